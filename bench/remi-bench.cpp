@@ -0,0 +1,369 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <margo.h>
+#include <thallium.hpp>
+#include <remi/remi-client.h>
+#include <remi/remi-server.h>
+#include "fs-util.hpp"
+
+namespace tl = thallium;
+
+/*
+ * remi-bench: end-to-end migration benchmark.
+ *
+ * A provider and a client are started in this process, on two distinct
+ * margo instances, so migrations go through the network layer (na+sm or
+ * ofi+tcp loopback) and never take the local fast path unless the "local"
+ * mode is requested. Synthetic filesets are generated under the data
+ * directory (use a tmpfs such as /dev/shm or a local disk) and migrated
+ * for every combination of the swept parameters.
+ */
+
+struct options {
+    std::string              protocol   = "na+sm";
+    std::string              directory  = "/dev/shm/remi-bench";
+    std::vector<size_t>      num_files  = {16};
+    std::vector<std::string> file_sizes = {"1M"};
+    std::vector<std::string> modes      = {"mmap", "abtio"};
+    std::vector<std::string> xfer_sizes = {"1M"};
+    std::vector<size_t>      concurrency = {1};
+    unsigned                 repetitions = 5;
+    unsigned                 seed        = 1234;
+    std::string              format      = "csv";
+    std::string              output;
+};
+
+struct result {
+    std::string mode;
+    std::string xfer_size;
+    size_t      num_files;
+    std::string file_size;
+    size_t      concurrency;
+    size_t      bytes;
+    size_t      failures;
+    double      seconds;
+    double      p50;
+    double      p99;
+    double      cpu;
+};
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -p <protocol>      Mercury protocol (default na+sm)\n"
+        "  -d <directory>     Where to generate and migrate files (default /dev/shm/remi-bench)\n"
+        "  -n <n1,n2,...>     Number of files per fileset (default 16)\n"
+        "  -s <s1,s2,...>     File sizes, each either SIZE or MIN-MAX for sizes drawn\n"
+        "                     uniformly in [MIN,MAX], with K/M/G suffixes (default 1M)\n"
+        "  -m <m1,m2,...>     Modes among mmap, abtio, zerocopy, local (default mmap,abtio)\n"
+        "  -x <x1,x2,...>     Transfer sizes for the abtio modes, or auto (default 1M)\n"
+        "  -c <c1,c2,...>     Number of concurrent migrations (default 1)\n"
+        "  -r <repetitions>   Repetitions of each configuration (default 5)\n"
+        "  -S <seed>          Seed used to generate file sizes and content (default 1234)\n"
+        "  -f <csv|json>      Output format (default csv)\n"
+        "  -o <file>          Output file (default stdout)\n", prog);
+}
+
+static std::vector<std::string> split(const std::string& str, char sep)
+{
+    std::vector<std::string> result;
+    size_t start = 0;
+    while(true) {
+        size_t end = str.find(sep, start);
+        result.push_back(str.substr(start, end - start));
+        if(end == std::string::npos) break;
+        start = end + 1;
+    }
+    return result;
+}
+
+static size_t parse_size(const std::string& str)
+{
+    char* end = nullptr;
+    size_t value = strtoull(str.c_str(), &end, 10);
+    switch(*end) {
+    case 'k': case 'K': return value << 10;
+    case 'm': case 'M': return value << 20;
+    case 'g': case 'G': return value << 30;
+    default: return value;
+    }
+}
+
+static int parse_mode(const std::string& mode)
+{
+    if(mode == "mmap")     return REMI_USE_MMAP;
+    if(mode == "abtio")    return REMI_USE_ABTIO;
+    if(mode == "zerocopy") return REMI_USE_ABTIO | REMI_USE_ZEROCOPY;
+    if(mode == "local")    return REMI_USE_LOCAL;
+    return -1;
+}
+
+static bool parse_options(int argc, char** argv, options& opts)
+{
+    int c;
+    while((c = getopt(argc, argv, "p:d:n:s:m:x:c:r:S:f:o:h")) != -1) {
+        switch(c) {
+        case 'p': opts.protocol = optarg; break;
+        case 'd': opts.directory = optarg; break;
+        case 'n':
+            opts.num_files.clear();
+            for(auto& s : split(optarg, ',')) opts.num_files.push_back(std::stoul(s));
+            break;
+        case 's': opts.file_sizes = split(optarg, ','); break;
+        case 'm': opts.modes = split(optarg, ','); break;
+        case 'x': opts.xfer_sizes = split(optarg, ','); break;
+        case 'c':
+            opts.concurrency.clear();
+            for(auto& s : split(optarg, ',')) opts.concurrency.push_back(std::stoul(s));
+            break;
+        case 'r': opts.repetitions = std::stoul(optarg); break;
+        case 'S': opts.seed = std::stoul(optarg); break;
+        case 'f': opts.format = optarg; break;
+        case 'o': opts.output = optarg; break;
+        default: return false;
+        }
+    }
+    for(auto& m : opts.modes)
+        if(parse_mode(m) < 0) return false;
+    return opts.format == "csv" || opts.format == "json";
+}
+
+static void remove_tree(const std::string& path)
+{
+    if(removeTreeAt(AT_FDCWD, path.c_str()) != 0)
+        fprintf(stderr, "WARNING: could not remove %s\n", path.c_str());
+}
+
+/**
+ * Generates num_files files under root, with sizes following the
+ * given specification, and returns their total size.
+ */
+static size_t generate_files(const std::string& root, size_t num_files,
+                             const std::string& size_spec, std::mt19937_64& rng)
+{
+    auto bounds = split(size_spec, '-');
+    size_t min_size = parse_size(bounds[0]);
+    size_t max_size = bounds.size() > 1 ? parse_size(bounds[1]) : min_size;
+    std::uniform_int_distribution<size_t> size_dist(min_size, max_size);
+
+    std::vector<uint64_t> buffer(1 << 17);
+    mkdir(root.c_str(), 0755);
+    size_t total = 0;
+    for(size_t i = 0; i < num_files; i++) {
+        auto filename = root + "/file" + std::to_string(i);
+        int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd == -1) {
+            perror("open");
+            exit(-1);
+        }
+        size_t size = size_dist(rng);
+        for(size_t off = 0; off < size; off += buffer.size()*sizeof(uint64_t)) {
+            for(auto& w : buffer) w = rng();
+            size_t n = std::min(size - off, buffer.size()*sizeof(uint64_t));
+            if(pwrite(fd, buffer.data(), n, off) != (ssize_t)n) {
+                perror("pwrite");
+                exit(-1);
+            }
+        }
+        close(fd);
+        total += size;
+    }
+    return total;
+}
+
+static double cpu_time()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec*1e-6
+         + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec*1e-6;
+}
+
+static double percentile(std::vector<double> values, double p)
+{
+    if(values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size()-1, (size_t)(p * (values.size()-1) + 0.5));
+    return values[index];
+}
+
+static void print_results(FILE* out, const std::string& format, const std::vector<result>& results)
+{
+    if(format == "csv") {
+        fprintf(out, "mode,xfer_size,files,file_size,concurrency,bytes,failures,"
+                     "seconds,gbps,files_per_s,p50_ms,p99_ms,cpu_percent\n");
+    } else {
+        fprintf(out, "[\n");
+    }
+    for(size_t i = 0; i < results.size(); i++) {
+        auto& r = results[i];
+        double gbps  = r.bytes / r.seconds / 1e9;
+        double files = (r.num_files * r.concurrency) / r.seconds;
+        if(format == "csv") {
+            fprintf(out, "%s,%s,%zu,%s,%zu,%zu,%zu,%f,%f,%f,%f,%f,%f\n",
+                    r.mode.c_str(), r.xfer_size.c_str(), r.num_files, r.file_size.c_str(),
+                    r.concurrency, r.bytes, r.failures, r.seconds, gbps, files,
+                    r.p50*1e3, r.p99*1e3, r.cpu*100.0);
+        } else {
+            fprintf(out, "  {\"mode\":\"%s\",\"xfer_size\":\"%s\",\"files\":%zu,\"file_size\":\"%s\","
+                         "\"concurrency\":%zu,\"bytes\":%zu,\"failures\":%zu,\"seconds\":%f,"
+                         "\"gbps\":%f,\"files_per_s\":%f,\"p50_ms\":%f,\"p99_ms\":%f,"
+                         "\"cpu_percent\":%f}%s\n",
+                    r.mode.c_str(), r.xfer_size.c_str(), r.num_files, r.file_size.c_str(),
+                    r.concurrency, r.bytes, r.failures, r.seconds, gbps, files,
+                    r.p50*1e3, r.p99*1e3, r.cpu*100.0, i+1 < results.size() ? "," : "");
+        }
+    }
+    if(format == "json")
+        fprintf(out, "]\n");
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+    if(!parse_options(argc, argv, opts)) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    // provider side
+    margo_instance_id server_mid = margo_init(opts.protocol.c_str(), MARGO_SERVER_MODE, 0, 2);
+    if(server_mid == MARGO_INSTANCE_NULL) {
+        fprintf(stderr, "ERROR: could not initialize margo with protocol %s\n", opts.protocol.c_str());
+        return -1;
+    }
+    abt_io_instance_id server_abtio = abt_io_init(2);
+    remi_provider_t provider;
+    remi_provider_register(server_mid, server_abtio, 1, REMI_ABT_POOL_DEFAULT, &provider);
+    remi_provider_register_migration_class(provider, "bench", NULL, NULL, NULL, NULL);
+
+    // client side, on a separate margo instance
+    margo_instance_id client_mid = margo_init(opts.protocol.c_str(), MARGO_SERVER_MODE, 0, 0);
+    abt_io_instance_id client_abtio = abt_io_init(2);
+    remi_client_t client;
+    remi_client_init(client_mid, client_abtio, &client);
+
+    hg_addr_t server_addr;
+    margo_addr_self(server_mid, &server_addr);
+    char addr_str[256];
+    hg_size_t addr_size = sizeof(addr_str);
+    margo_addr_to_string(server_mid, addr_str, &addr_size, server_addr);
+    margo_addr_free(server_mid, server_addr);
+    margo_addr_lookup(client_mid, addr_str, &server_addr);
+
+    remi_provider_handle_t ph;
+    if(remi_provider_handle_create(client, server_addr, 1, &ph) != REMI_SUCCESS) {
+        fprintf(stderr, "ERROR: could not create provider handle\n");
+        return -1;
+    }
+
+    remove_tree(opts.directory);
+    mkdir(opts.directory.c_str(), 0755);
+    std::mt19937_64 rng(opts.seed);
+    tl::engine engine(client_mid);
+    std::vector<result> results;
+
+    size_t max_concurrency = *std::max_element(opts.concurrency.begin(), opts.concurrency.end());
+
+    for(auto num_files : opts.num_files) {
+    for(auto& file_size : opts.file_sizes) {
+        // one source fileset per concurrent migration
+        std::vector<size_t> fileset_bytes;
+        for(size_t k = 0; k < max_concurrency; k++) {
+            auto root = opts.directory + "/src" + std::to_string(k);
+            remove_tree(root);
+            fileset_bytes.push_back(generate_files(root, num_files, file_size, rng));
+        }
+        for(auto& mode_name : opts.modes) {
+        int mode = parse_mode(mode_name);
+        bool chunked = mode & REMI_USE_ABTIO;
+        std::vector<std::string> xfer_sizes = chunked ? opts.xfer_sizes : std::vector<std::string>{"-"};
+        for(auto& xfer_size : xfer_sizes) {
+        for(auto concurrency : opts.concurrency) {
+
+            std::vector<remi_fileset_t> filesets(concurrency);
+            for(size_t k = 0; k < concurrency; k++) {
+                auto root = opts.directory + "/src" + std::to_string(k);
+                remi_fileset_create("bench", root.c_str(), &filesets[k]);
+                for(size_t i = 0; i < num_files; i++)
+                    remi_fileset_register_file(filesets[k], ("file" + std::to_string(i)).c_str());
+                if(chunked)
+                    remi_fileset_set_xfer_size(filesets[k],
+                        xfer_size == "auto" ? REMI_XFER_SIZE_AUTO : parse_size(xfer_size));
+            }
+
+            result r{mode_name, xfer_size, num_files, file_size, concurrency, 0, 0, 0.0, 0.0, 0.0, 0.0};
+            std::vector<double> latencies;
+            for(unsigned rep = 0; rep < opts.repetitions; rep++) {
+                std::vector<double> rep_latencies(concurrency);
+                std::vector<int> rets(concurrency);
+                std::vector<tl::managed<tl::thread>> ults;
+                double cpu_start  = cpu_time();
+                double wall_start = tl::timer::wtime();
+                for(size_t k = 0; k < concurrency; k++) {
+                    ults.push_back(engine.get_handler_pool().make_thread([&, k]() {
+                        auto dest = opts.directory + "/dst" + std::to_string(k);
+                        int status = 0;
+                        double t = tl::timer::wtime();
+                        rets[k] = remi_fileset_migrate(ph, filesets[k], dest.c_str(),
+                                REMI_KEEP_SOURCE, mode, &status);
+                        rep_latencies[k] = tl::timer::wtime() - t;
+                    }));
+                }
+                for(auto& ult : ults)
+                    ult->join();
+                r.seconds += tl::timer::wtime() - wall_start;
+                r.cpu     += cpu_time() - cpu_start;
+                for(size_t k = 0; k < concurrency; k++) {
+                    if(rets[k] == REMI_SUCCESS) {
+                        r.bytes += fileset_bytes[k];
+                        latencies.push_back(rep_latencies[k]);
+                    } else {
+                        fprintf(stderr, "WARNING: migration returned %d\n", rets[k]);
+                        r.failures += 1;
+                    }
+                    remove_tree(opts.directory + "/dst" + std::to_string(k));
+                }
+            }
+            r.cpu /= r.seconds;
+            r.p50 = percentile(latencies, 0.50);
+            r.p99 = percentile(latencies, 0.99);
+            results.push_back(r);
+
+            for(auto fs : filesets)
+                remi_fileset_free(fs);
+        }}}
+    }}
+
+    remove_tree(opts.directory);
+
+    FILE* out = opts.output.empty() ? stdout : fopen(opts.output.c_str(), "w");
+    print_results(out, opts.format, results);
+    if(out != stdout) fclose(out);
+
+    remi_provider_handle_release(ph);
+    margo_addr_free(client_mid, server_addr);
+    remi_client_finalize(client);
+    margo_finalize(client_mid);
+    abt_io_finalize(client_abtio);
+    margo_finalize(server_mid);
+    abt_io_finalize(server_abtio);
+    return 0;
+}
@@ -0,0 +1,286 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <margo.h>
+#include <thallium.hpp>
+#include <remi/remi-client.h>
+#include <remi/remi-server.h>
+#include "remi-fileset.hpp"
+#include "fs-util.hpp"
+
+namespace tl = thallium;
+
+/*
+ * remi-microbench: benchmarks of the metadata-heavy parts of a migration.
+ *
+ *  - walk_wide / walk_deep: remi_fileset_walkthrough on a directory holding
+ *    all the files, and on a chain of nested directories;
+ *  - serialize: sending a remi_fileset with N files and N/10 metadata
+ *    entries in an RPC (serialization and deserialization);
+ *  - preflight: migrating N empty files spread across directories, which
+ *    reduces the migration to migrate_start's access/mkdirs/open loop and
+ *    migrate_end.
+ *
+ * Each benchmark reports its time per entry. Given a thresholds file
+ * (lines of "<benchmark> <max microseconds per entry>"), the program
+ * exits with an error if any benchmark exceeds its threshold.
+ */
+
+struct options {
+    std::string         protocol   = "na+sm";
+    std::string         directory  = "/dev/shm/remi-microbench";
+    std::vector<size_t> entries    = {1000, 10000, 100000};
+    unsigned            repetitions = 3;
+    std::string         thresholds;
+};
+
+struct result {
+    std::string name;
+    size_t      entries;
+    double      seconds;
+};
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -p <protocol>    Mercury protocol (default na+sm)\n"
+        "  -d <directory>   Where to create the trees (default /dev/shm/remi-microbench)\n"
+        "  -n <n1,n2,...>   Number of entries (default 1000,10000,100000)\n"
+        "  -r <repetitions> Repetitions, the best time is kept (default 3)\n"
+        "  -t <file>        Thresholds file\n", prog);
+}
+
+static bool parse_options(int argc, char** argv, options& opts)
+{
+    int c;
+    while((c = getopt(argc, argv, "p:d:n:r:t:h")) != -1) {
+        switch(c) {
+        case 'p': opts.protocol = optarg; break;
+        case 'd': opts.directory = optarg; break;
+        case 'n': {
+            opts.entries.clear();
+            std::string list(optarg);
+            size_t start = 0;
+            while(true) {
+                size_t end = list.find(',', start);
+                opts.entries.push_back(std::stoul(list.substr(start, end - start)));
+                if(end == std::string::npos) break;
+                start = end + 1;
+            }
+            break;
+        }
+        case 'r': opts.repetitions = std::stoul(optarg); break;
+        case 't': opts.thresholds = optarg; break;
+        default: return false;
+        }
+    }
+    return opts.repetitions > 0;
+}
+
+static void touch(const std::string& filename)
+{
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd == -1) {
+        perror("open");
+        exit(-1);
+    }
+    close(fd);
+}
+
+/* creates n empty files under root/wide */
+static void make_wide_tree(const std::string& root, size_t n)
+{
+    auto dir = root + "/wide";
+    mkdirs(dir.c_str());
+    for(size_t i = 0; i < n; i++)
+        touch(dir + "/f" + std::to_string(i));
+}
+
+/* creates n empty files under root/deep, 10 per level of nesting */
+static void make_deep_tree(const std::string& root, size_t n)
+{
+    auto dir = root + "/deep";
+    for(size_t i = 0; i < n; i++) {
+        if(i % 10 == 0) {
+            dir += "/d" + std::to_string(i / 10);
+            // keep the path length reasonable, restart a chain
+            if(dir.size() > 3000)
+                dir = root + "/deep/d" + std::to_string(i / 10);
+            mkdirs(dir.c_str());
+        }
+        touch(dir + "/f" + std::to_string(i));
+    }
+}
+
+static void count_file(const char*, void* uargs)
+{
+    *static_cast<size_t*>(uargs) += 1;
+}
+
+/* runs f repetitions times and returns its best time; teardown,
+   which is not timed, runs after each repetition */
+template<typename F, typename T>
+static double best_of(unsigned repetitions, F&& f, T&& teardown)
+{
+    double best = -1.0;
+    for(unsigned i = 0; i < repetitions; i++) {
+        double t = tl::timer::wtime();
+        f();
+        t = tl::timer::wtime() - t;
+        teardown();
+        if(best < 0.0 || t < best) best = t;
+    }
+    return best;
+}
+
+template<typename F>
+static double best_of(unsigned repetitions, F&& f)
+{
+    return best_of(repetitions, std::forward<F>(f), []() {});
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+    if(!parse_options(argc, argv, opts)) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    std::map<std::string, double> thresholds;
+    if(!opts.thresholds.empty()) {
+        std::ifstream in(opts.thresholds);
+        if(!in) {
+            fprintf(stderr, "ERROR: could not read %s\n", opts.thresholds.c_str());
+            return -1;
+        }
+        std::string name;
+        double us;
+        while(in >> name >> us)
+            thresholds[name] = us;
+    }
+
+    // provider and client on separate margo instances, so that
+    // migrations are not turned into local copies
+    margo_instance_id server_mid = margo_init(opts.protocol.c_str(), MARGO_SERVER_MODE, 0, 1);
+    if(server_mid == MARGO_INSTANCE_NULL) {
+        fprintf(stderr, "ERROR: could not initialize margo with protocol %s\n", opts.protocol.c_str());
+        return -1;
+    }
+    remi_provider_t provider;
+    remi_provider_register(server_mid, ABT_IO_INSTANCE_NULL, 1, REMI_ABT_POOL_DEFAULT, &provider);
+    remi_provider_register_migration_class(provider, "bench", NULL, NULL, NULL, NULL);
+    tl::engine server_engine(server_mid);
+    server_engine.define("remi_microbench_fileset",
+        [](const tl::request& req, const remi_fileset& fileset) {
+            req.respond(fileset.m_files.size());
+        });
+
+    margo_instance_id client_mid = margo_init(opts.protocol.c_str(), MARGO_SERVER_MODE, 0, 0);
+    tl::engine client_engine(client_mid);
+    auto fileset_rpc = client_engine.define("remi_microbench_fileset");
+    remi_client_t client;
+    remi_client_init(client_mid, ABT_IO_INSTANCE_NULL, &client);
+
+    auto server_ep = client_engine.lookup(static_cast<std::string>(server_engine.self()));
+    remi_provider_handle_t ph;
+    if(remi_provider_handle_create(client, server_ep.get_addr(), 1, &ph) != REMI_SUCCESS) {
+        fprintf(stderr, "ERROR: could not create provider handle\n");
+        return -1;
+    }
+
+    std::vector<result> results;
+    for(auto n : opts.entries) {
+        auto root = opts.directory + "/" + std::to_string(n);
+        removeRec(root);
+        mkdirs(root.c_str());
+        make_wide_tree(root, n);
+        make_deep_tree(root, n);
+
+        // walkthrough
+        for(std::string tree : {"wide", "deep"}) {
+            remi_fileset_t fileset;
+            remi_fileset_create("bench", root.c_str(), &fileset);
+            remi_fileset_register_directory(fileset, tree.c_str());
+            double t = best_of(opts.repetitions, [&]() {
+                size_t count = 0;
+                remi_fileset_walkthrough(fileset, count_file, &count);
+            });
+            results.push_back({"walk_" + tree, n, t});
+            remi_fileset_free(fileset);
+        }
+
+        // serialization of the fileset sent by migrate_start
+        {
+            remi_fileset fileset;
+            fileset.m_class = "bench";
+            fileset.m_provider_id = 0;
+            fileset.m_root = root + "/";
+            for(size_t i = 0; i < n; i++)
+                fileset.m_files.insert("deep/d" + std::to_string(i / 10) + "/f" + std::to_string(i));
+            for(size_t i = 0; i < n / 10; i++)
+                fileset.m_metadata["key" + std::to_string(i)] = "value" + std::to_string(i);
+            double t = best_of(opts.repetitions, [&]() {
+                size_t count = fileset_rpc.on(server_ep)(fileset);
+                (void)count;
+            });
+            results.push_back({"serialize", n, t});
+        }
+
+        // preflight: migrate empty files, so start and end dominate
+        {
+            remi_fileset_t fileset;
+            remi_fileset_create("bench", root.c_str(), &fileset);
+            remi_fileset_register_directory(fileset, "deep");
+            auto dest = root + "/dest";
+            double t = best_of(opts.repetitions, [&]() {
+                int status = 0;
+                int ret = remi_fileset_migrate(ph, fileset, dest.c_str(),
+                        REMI_KEEP_SOURCE, REMI_USE_ABTIO, &status);
+                if(ret != REMI_SUCCESS)
+                    fprintf(stderr, "WARNING: migration returned %d\n", ret);
+            }, [&]() {
+                removeRec(dest);
+            });
+            results.push_back({"preflight", n, t});
+            remi_fileset_free(fileset);
+        }
+
+        removeRec(root);
+    }
+
+    int ret = 0;
+    printf("benchmark,entries,seconds,us_per_entry,threshold_us,status\n");
+    for(auto& r : results) {
+        double us = r.seconds * 1e6 / r.entries;
+        auto it = thresholds.find(r.name);
+        const char* status = "-";
+        double threshold = 0.0;
+        if(it != thresholds.end()) {
+            threshold = it->second;
+            status = us <= threshold ? "ok" : "REGRESSION";
+            if(us > threshold) ret = 1;
+        }
+        printf("%s,%zu,%f,%f,%f,%s\n", r.name.c_str(), r.entries, r.seconds, us, threshold, status);
+    }
+
+    remi_provider_handle_release(ph);
+    remi_client_finalize(client);
+    margo_finalize(client_mid);
+    margo_finalize(server_mid);
+    return ret;
+}
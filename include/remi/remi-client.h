@@ -26,6 +26,33 @@ typedef struct remi_client* remi_client_t;
 typedef struct remi_provider_handle* remi_provider_handle_t;
 #define REMI_PROVIDER_HANDLE_NULL ((remi_provider_handle_t)0)
 
+/**
+ * @brief Progress of a migration.
+ */
+typedef struct remi_progress {
+    char     operation_id[37]; /* empty until the target accepted the migration */
+    uint64_t bytes_total;      /* bytes to migrate */
+    uint64_t bytes_sent;       /* bytes handed to the network */
+    uint64_t bytes_acked;      /* bytes acknowledged by the target */
+    uint64_t files_total;      /* files to migrate */
+    uint64_t files_completed;  /* files fully acknowledged by the target */
+    double   elapsed;          /* seconds since the migration started */
+    double   throughput;       /* bytes acknowledged per second */
+    double   eta;              /* estimated seconds remaining, negative if unknown */
+    int      done;             /* 1 once the migration has returned */
+    int      durability;       /* REMI_DURABILITY_* policy the target applied,
+                                  REMI_DURABILITY_DEFAULT until it has reported it */
+} remi_progress_t;
+
+/**
+ * @brief Callback called as a migration progresses. It is called
+ * from the ULT running remi_fileset_migrate, with the current progress
+ * and the user arguments provided with the callback, and should
+ * return quickly.
+ */
+typedef void (*remi_progress_callback_t)(const remi_progress_t*, void*);
+#define REMI_PROGRESS_CALLBACK_NULL ((remi_progress_callback_t)0)
+
 /**
  * @brief Initializes a REMI client.
  *
@@ -50,7 +77,15 @@ int remi_client_init(
 int remi_client_finalize(remi_client_t client);
 
 /**
- * @brief Creates a REMI provider handle.
+ * @brief Creates a REMI provider handle. Handles are cached by the
+ * client: creating a handle for a provider the client already has a
+ * handle for returns that handle with its reference count incremented,
+ * along with the RPC state it kept from previous migrations. Up to 256
+ * handles are cached; beyond that, handles that are no longer referenced
+ * outside of the cache are dropped from it. Whether the target is a REMI
+ * provider is checked when the handle is first used, and again on every
+ * use until the check succeeds; while it fails, calls using the handle
+ * return REMI_ERR_UNKNOWN_PR.
  *
  * @param[in] client REMI client.
  * @param[in] addr Mercury address of the provider.
@@ -100,13 +135,44 @@ int remi_shutdown_service(remi_client_t client, hg_addr_t addr);
  * of the local fileset will be transfered over RDMA to the destination
  * provider and a remote fileset will be created with the provided
  * remote root. If flag is set to REMI_REMOVE_SOURCE, the original
- * files will be destroyed.
+ * files will be destroyed once the migration has succeeded. With
+ * REMI_REMOVE_SOURCE_BACKGROUND, they are destroyed in the background
+ * after this function returns (see remi_client_wait_source_removals).
+ * Removals are spread over several ULTs of the client's I/O pool
+ * (see remi_client_set_io_pool), or of its handler pool if none was set.
+ *
+ * If REMI_USE_LOCAL is added to the mode, or if the provider lives in
+ * the calling process, the provider is first asked to copy the files
+ * itself (using reflinks, copy_file_range, or hard links when the source
+ * is to be removed). The data only goes through the network if the
+ * provider cannot see the source files, or if they are not under one of
+ * the directories it may read (see remi_provider_add_source_root).
+ *
+ * The target rejects the migration with REMI_ERR_NO_SPACE before any data
+ * is sent if the file system receiving it lacks the space or inodes the
+ * fileset needs, accounting for the other migrations in progress.
+ *
+ * If REMI_USE_ZEROCOPY is added to REMI_USE_ABTIO, chunks are not copied
+ * into the RPCs; the provider pulls them from the client's buffers into
+ * mmap-ed windows of the target files instead.
+ *
+ * If REMI_USE_DEDUP is added to REMI_USE_ABTIO, the client hashes the
+ * files before the migration and the provider, if it has deduplication
+ * enabled (see remi_provider_enable_dedup), reuses the files it already
+ * holds with the same content instead of receiving them again.
+ *
+ * If the provider runs its "after" callbacks asynchronously (see
+ * remi_provider_set_callback_pool), this function may return REMI_SUCCESS
+ * before the callback has run, and status is then 0 even if the callback
+ * later fails; its outcome must be obtained with remi_get_callback_status.
  *
  * @param handle Provider handle of the target provider.
  * @param fileset Fileset to migrate.
  * @param remote_root Root of the fileset when migrated.
- * @param remove_source REMI_REMOVE_SOURCE or REMI_KEEP_SOURCE.
- * @param mode REMI_USE_MMAP or REMI_USE_ABTIO.
+ * @param remove_source REMI_REMOVE_SOURCE, REMI_REMOVE_SOURCE_BACKGROUND
+ *                      or REMI_KEEP_SOURCE.
+ * @param mode REMI_USE_MMAP or REMI_USE_ABTIO, optionally | REMI_USE_LOCAL
+ *             and/or REMI_USE_ZEROCOPY and/or REMI_USE_DEDUP.
  * @param status Value returned by the user-defined migration callbacks.
  *
  * @return REMI_SUCCESS or error code defined in remi-common.h.
@@ -119,6 +185,174 @@ int remi_fileset_migrate(
         int mode,
         int* status);
 
+/**
+ * @brief Migrates a fileset to a remote node through several provider
+ * handles, for instance one per network rail or one per provider id,
+ * all of which must refer to providers living in the same process on
+ * the target node. The migration is started and completed through the
+ * first handle; with REMI_USE_ABTIO, its chunks are spread over all the
+ * handles in a round-robin manner, each handle keeping the client's
+ * pipeline depth of chunks in flight, and reassembled by the target into
+ * the same files. Other modes only use the first handle.
+ * With a single handle, this is equivalent to remi_fileset_migrate.
+ *
+ * @param handles Array of provider handles of the target node.
+ * @param count Number of handles (at least 1).
+ * @param fileset Fileset to migrate.
+ * @param remote_root Root of the fileset when migrated.
+ * @param remove_source Same as for remi_fileset_migrate.
+ * @param mode Same as for remi_fileset_migrate.
+ * @param status Value returned by the user-defined migration callbacks.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_fileset_migrate_striped(
+        remi_provider_handle_t* handles,
+        size_t count,
+        remi_fileset_t fileset,
+        const char* remote_root,
+        int remove_source,
+        int mode,
+        int* status);
+
+/**
+ * @brief Migrates several independent filesets, possibly of different
+ * classes, to the same provider. Small filesets are sent along with their
+ * content in a few RPCs, each of which the provider handles by migrating
+ * the filesets it carries concurrently, calling their callbacks as
+ * remi_fileset_migrate would, instead of one start, transfer and end
+ * round trip per fileset. Larger filesets, and all of them if
+ * REMI_USE_LOCAL is requested or the provider is in this process, are
+ * migrated one after the other with remi_fileset_migrate. The batches
+ * count against the client's rate limit and go out at the highest
+ * priority of the filesets they carry.
+ *
+ * @param handle Provider handle of the target provider.
+ * @param filesets Array of count filesets.
+ * @param remote_roots Array of count roots, one per fileset.
+ * @param count Number of filesets.
+ * @param remove_source Same as for remi_fileset_migrate, for all filesets.
+ * @param mode Same as for remi_fileset_migrate, for all filesets.
+ * @param statuses Array of count values returned by the callbacks,
+ * set for the filesets whose result is REMI_ERR_USER and 0 otherwise.
+ * @param results Array of count error codes, one per fileset.
+ *
+ * @return REMI_SUCCESS if all the filesets were migrated, otherwise
+ * the error code of the first fileset that failed.
+ */
+int remi_fileset_migrate_batch(
+        remi_provider_handle_t handle,
+        remi_fileset_t* filesets,
+        const char** remote_roots,
+        size_t count,
+        int remove_source,
+        int mode,
+        int* statuses,
+        int* results);
+
+/**
+ * @brief Asks a provider to pull a fileset from another REMI provider
+ * (the source) instead of having the client push it, for instance to
+ * populate a node that joins a service. The root, files and directories
+ * of the fileset refer to the source's file system; the source resolves
+ * and opens the files, then the destination asks for them a piece at a
+ * time, at its own pace, through its own priorities, rate limit and I/O
+ * backend, and writes them under local_root. The class of the fileset
+ * must be registered with the destination, whose callbacks are called as
+ * for remi_fileset_migrate, and with the source, which only exposes files
+ * under the roots added with remi_provider_add_source_root. The source
+ * reads each piece when it is asked for it and only keeps the files open
+ * until the pull completes, or until the destination has not asked for
+ * a piece for ten minutes. The source files are left in place.
+ *
+ * @param handle Provider handle of the destination provider.
+ * @param source_address Address of the source provider.
+ * @param source_provider_id Provider id of the source provider.
+ * @param fileset Fileset to pull.
+ * @param local_root Root of the fileset on the destination.
+ * @param status Value returned by the user-defined migration callbacks.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_fileset_pull(
+        remi_provider_handle_t handle,
+        const char* source_address,
+        uint16_t source_provider_id,
+        remi_fileset_t fileset,
+        const char* local_root,
+        int* status);
+
+/**
+ * @brief Sets a callback to be called as migrations of the fileset
+ * progress: when the target accepts the migration, every time it
+ * acknowledges a chunk of data, and when the migration completes.
+ * Passing REMI_PROGRESS_CALLBACK_NULL removes the callback.
+ *
+ * @param fileset Fileset.
+ * @param callback Callback.
+ * @param uargs User arguments passed to the callback.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_fileset_set_progress_callback(
+        remi_fileset_t fileset,
+        remi_progress_callback_t callback,
+        void* uargs);
+
+/**
+ * @brief Gets the progress of the current (or last) migration of the
+ * fileset. This function may be called from another ULT while
+ * remi_fileset_migrate is running.
+ *
+ * @param[in] fileset Fileset.
+ * @param[out] progress Resulting progress.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_fileset_get_progress(
+        remi_fileset_t fileset,
+        remi_progress_t* progress);
+
+/**
+ * @brief Asks the target provider for the state of a migration in
+ * progress, identified by the operation_id reported in its progress.
+ * The bytes and files reported are those the provider has written.
+ * Returns REMI_ERR_INVALID_OPID if the provider does not know the
+ * operation, e.g. because it has completed.
+ *
+ * @param[in] handle Provider handle.
+ * @param[in] operation_id Operation id.
+ * @param[out] progress Resulting progress.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_get_migration_status(
+        remi_provider_handle_t handle,
+        const char* operation_id,
+        remi_progress_t* progress);
+
+/**
+ * @brief Asks the target provider for the outcome of the "after" callback
+ * of a migration, when the provider runs these callbacks asynchronously
+ * (see remi_provider_set_callback_pool). In that case remi_fileset_migrate
+ * returns once the files are in place and durable, and the operation_id
+ * to pass here is the one reported in the fileset's progress. Returns
+ * REMI_ERR_PENDING while the callback runs, then REMI_SUCCESS or
+ * REMI_ERR_USER with the value it returned in status. An outcome is
+ * reported only once; REMI_ERR_INVALID_OPID is returned afterwards, and
+ * for migrations whose callback ran synchronously.
+ *
+ * @param[in] handle Provider handle.
+ * @param[in] operation_id Operation id.
+ * @param[out] status Value returned by the "after" callback.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_get_callback_status(
+        remi_provider_handle_t handle,
+        const char* operation_id,
+        int* status);
+
 /**
  * @brief Sets the ABT-IO instance to use for I/O.
  *
@@ -131,6 +365,151 @@ int remi_client_set_abt_io_instance(
         remi_client_t client,
         abt_io_instance_id abtio);
 
+/**
+ * @brief Selects the backend used to read files (REMI_IO_DEFAULT,
+ * REMI_IO_POSIX, REMI_IO_ABTIO, or REMI_IO_URING). This function
+ * should not be called while migrations are in progress.
+ *
+ * @param client Client.
+ * @param backend I/O backend.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_client_set_io_backend(
+        remi_client_t client,
+        int backend);
+
+/**
+ * @brief Sets the pool in which the client runs its background I/O work
+ * (source removals, or the system calls of the REMI_IO_XSTREAM backend
+ * instead of a dedicated execution stream).
+ * This function should not be called while migrations are in progress.
+ *
+ * @param client Client.
+ * @param pool Argobots pool, or ABT_POOL_NULL to revert to the default.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_client_set_io_pool(
+        remi_client_t client,
+        ABT_pool pool);
+
+/**
+ * @brief Sets the mode used by remi_fileset_migrate when it is called
+ * with REMI_USE_DEFAULT.
+ *
+ * @param client Client.
+ * @param mode Combination of REMI_USE_* flags.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_client_set_default_mode(
+        remi_client_t client,
+        int mode);
+
+/**
+ * @brief Sets the transfer size used for filesets whose transfer size
+ * was not set with remi_fileset_set_xfer_size (1MB by default).
+ * REMI_XFER_SIZE_AUTO enables auto-tuning for such filesets.
+ *
+ * @param client Client.
+ * @param size Transfer size.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_client_set_default_xfer_size(
+        remi_client_t client,
+        size_t size);
+
+/**
+ * @brief Sets the number of chunk RPCs a REMI_USE_ABTIO migration
+ * keeps in flight (2 by default). When the transfer size is
+ * REMI_XFER_SIZE_AUTO, this is only the initial depth.
+ *
+ * @param client Client.
+ * @param depth Pipeline depth (at least 1).
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_client_set_pipeline_depth(
+        remi_client_t client,
+        size_t depth);
+
+/**
+ * @brief Sets the number of chunk buffers the client keeps once
+ * a migration completes, to be reused by the next migrations instead
+ * of being allocated again (0 by default).
+ *
+ * @param client Client.
+ * @param count Maximum number of buffers kept.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_client_set_buffer_pool_size(
+        remi_client_t client,
+        size_t count);
+
+/**
+ * @brief Limits the rate at which the client sends data, in bytes per
+ * second and in operations (chunks, or whole filesets for the
+ * REMI_USE_MMAP and REMI_USE_LOCAL modes) per second. Transfers exceeding
+ * the limits are delayed. A limit of 0 means unlimited (the default).
+ * This function may be called at any time.
+ *
+ * @param client Client.
+ * @param bytes_per_sec Maximum bandwidth.
+ * @param ops_per_sec Maximum number of operations per second.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_client_set_rate_limit(
+        remi_client_t client,
+        uint64_t bytes_per_sec,
+        uint64_t ops_per_sec);
+
+/**
+ * @brief Waits until the sources of all the migrations issued with
+ * REMI_REMOVE_SOURCE_BACKGROUND have been removed. This function is
+ * called by remi_client_finalize.
+ *
+ * @param client Client.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_client_wait_source_removals(remi_client_t client);
+
+/**
+ * @brief Gets the counters maintained by the client since it was
+ * initialized (migrations, bytes and files sent, migrations in progress,
+ * time spent in each phase, chunk RPC latencies, I/O errors).
+ *
+ * @param[in] client Client.
+ * @param[out] stats Resulting counters.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_client_get_stats(
+        remi_client_t client,
+        remi_stats_t* stats);
+
+/**
+ * @brief Same as remi_client_get_stats but formats the counters as
+ * a JSON object. If buf is NULL, size is set to the size required to
+ * hold the string. Otherwise size should contain the number of bytes
+ * available in buf, and is set to the size of the string
+ * (including null-terminator).
+ *
+ * @param[in] client Client.
+ * @param[out] buf Buffer to hold the JSON string.
+ * @param[inout] size Size of the buffer/string.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_client_get_stats_json(
+        remi_client_t client,
+        char* buf,
+        size_t* size);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -14,9 +14,32 @@ extern "C" {
 
 #define REMI_KEEP_SOURCE   0    /* Keep the source files/directories */
 #define REMI_REMOVE_SOURCE 1    /* Remove the source files/directories */
+#define REMI_REMOVE_SOURCE_BACKGROUND 2 /* Remove them after the migration call has returned */
 
+#define REMI_USE_DEFAULT 0 /* Use the default mode of the client (REMI_USE_ABTIO unless changed) */
 #define REMI_USE_MMAP  2 /* Use mmap-ed files to issue transfers (good for memory-based storage) */
 #define REMI_USE_ABTIO 4 /* Use ABT-IO to pipeline read/write with data transfers (good for disks) */
+#define REMI_USE_LOCAL 8 /* Let the target copy, clone or link the files itself if it can see them */
+#define REMI_USE_ZEROCOPY 16 /* With REMI_USE_ABTIO, let the target pull chunks straight into its files */
+#define REMI_USE_DEDUP 32 /* With REMI_USE_ABTIO, skip files whose content the target already has */
+
+#define REMI_XFER_SIZE_AUTO 0 /* Tune the transfer size and pipeline depth during the migration */
+
+#define REMI_DURABILITY_DEFAULT  -1 /* Use the target provider's policy */
+#define REMI_DURABILITY_NONE      0 /* Leave the data in the target's page cache */
+#define REMI_DURABILITY_FDATASYNC 1 /* fdatasync every file, in parallel, when the migration ends */
+#define REMI_DURABILITY_SYNCFS    2 /* A single syncfs per file system when the migration ends */
+#define REMI_DURABILITY_WRITEBACK 3 /* Start writeback as data arrives, wait for it when the migration ends */
+
+#define REMI_PRIORITY_LOW    -10 /* Background traffic (e.g. rebalancing) */
+#define REMI_PRIORITY_DEFAULT  0 /* Priority of filesets for which none was set */
+#define REMI_PRIORITY_HIGH    10 /* Urgent traffic (e.g. draining a failing node) */
+
+#define REMI_IO_DEFAULT 0 /* ABT-IO if an ABT-IO instance is set, POSIX (provider) or XSTREAM (client) otherwise */
+#define REMI_IO_POSIX   1 /* Blocking POSIX calls */
+#define REMI_IO_ABTIO   2 /* Calls forwarded to ABT-IO */
+#define REMI_IO_URING   3 /* Batched io_uring submissions (if REMI was built with io_uring support) */
+#define REMI_IO_XSTREAM 4 /* Blocking POSIX calls issued from a dedicated execution stream */
 
 #define REMI_SUCCESS             0 /* Success */
 #define REMI_ERR_ALLOCATION     -1 /* Error allocating something */
@@ -33,6 +56,42 @@ extern "C" {
 #define REMI_ERR_IO            -12 /* Error in I/O (stat, open, etc.) call */
 #define REMI_ERR_USER          -13 /* User-defined error reported in "status" argument */
 #define REMI_ERR_INVALID_OPID  -14 /* Invalid UUID operation identifier received */
+#define REMI_ERR_NOT_LOCAL     -15 /* Source files are not visible from the target provider */
+#define REMI_ERR_NO_SPACE      -16 /* Not enough space on the target to receive the fileset */
+#define REMI_ERR_PENDING       -17 /* The "after" callback of the migration is still running */
+
+#define REMI_PHASE_START    0 /* Checking and creating the target files, "before" callback */
+#define REMI_PHASE_TRANSFER 1 /* Moving the data */
+#define REMI_PHASE_SYNC     2 /* Flushing the data to storage */
+#define REMI_PHASE_END      3 /* Closing the target files, "after" callback */
+#define REMI_NUM_PHASES     4
+
+#define REMI_STATS_NUM_BUCKETS 32 /* Buckets of the chunk latency histogram */
+
+/**
+ * @brief Latency of a phase of the migrations, in microseconds.
+ */
+typedef struct remi_latency {
+    uint64_t count;    /* number of times the phase was executed */
+    uint64_t total_us; /* cumulated time spent in the phase */
+    uint64_t max_us;   /* longest execution of the phase */
+} remi_latency_t;
+
+/**
+ * @brief Counters maintained by a client or a provider since its creation.
+ */
+typedef struct remi_stats {
+    uint64_t       bytes_migrated;    /* bytes of files successfully migrated */
+    uint64_t       files_migrated;    /* files successfully migrated */
+    uint64_t       migrations;        /* successful migrations */
+    uint64_t       failed_migrations; /* migrations that returned an error */
+    uint64_t       active_operations; /* migrations currently in progress */
+    uint64_t       io_errors;         /* failed I/O calls */
+    remi_latency_t phases[REMI_NUM_PHASES]; /* indexed by REMI_PHASE_* */
+    uint64_t       chunks;            /* chunks sent (client) or received (provider) */
+    uint64_t       chunk_latency[REMI_STATS_NUM_BUCKETS]; /* chunk_latency[i] counts chunks
+                                                             that took [2^i, 2^(i+1)) us */
+} remi_stats_t;
 
 /**
  * @brief Fileset type.
@@ -156,6 +215,15 @@ int remi_fileset_set_root(
  * option. It determins the maximum size of data an RPC is allowed to
  * transfer at once.
  *
+ * If the transfer size of a fileset is not set, the client's default
+ * transfer size is used (see remi_client_set_default_xfer_size).
+ *
+ * If set to REMI_XFER_SIZE_AUTO, the client measures the throughput it
+ * achieves while migrating and adjusts the transfer size and the number
+ * of RPCs in flight accordingly. The values it settles on are remembered
+ * per target provider and used as a starting point for the next migration
+ * to that provider.
+ *
  * @param[in] fileset Fileset for which to set the xfer size.
  * @param[in] size New size.
  *
@@ -177,6 +245,96 @@ int remi_fileset_get_xfer_size(
         remi_fileset_t fileset,
         size_t* size);
 
+/**
+ * @brief Sets the priority with which this fileset is migrated
+ * (REMI_PRIORITY_DEFAULT unless changed). Any integer can be used,
+ * larger meaning more urgent. The priority is sent to the target along
+ * with the fileset. While a migration is transferring data, on the
+ * client as well as on the provider, migrations of a lower priority
+ * pause between chunks and resume once it is done. The pull of a
+ * REMI_USE_MMAP migration is split into pieces so that it can be
+ * paused as well.
+ *
+ * @param[in] fileset Fileset for which to set the priority.
+ * @param[in] priority New priority.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_fileset_set_priority(
+        remi_fileset_t fileset,
+        int32_t priority);
+
+/**
+ * @brief Gets the priority of this fileset.
+ *
+ * @param[in] fileset Fileset for which to get the priority.
+ * @param[out] priority resulting priority.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_fileset_get_priority(
+        remi_fileset_t fileset,
+        int32_t* priority);
+
+/**
+ * @brief Enables or disables staging for this fileset (disabled by
+ * default). When staging is enabled, the target writes the files of a
+ * migration into a hidden directory under the remote root
+ * (.remi-staging-<operation id>) and, once all the data has been
+ * received, renames each of them into place without replacing any
+ * existing file. Readers of the remote root thus never see partially
+ * written files, and a failed migration leaves nothing behind but its
+ * staging directory, which the target removes.
+ *
+ * @param[in] fileset Fileset.
+ * @param[in] staging 1 to enable staging, 0 to disable it.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_fileset_set_staging(
+        remi_fileset_t fileset,
+        int staging);
+
+/**
+ * @brief Gets whether staging is enabled for this fileset.
+ *
+ * @param[in] fileset Fileset.
+ * @param[out] staging 1 if staging is enabled, 0 otherwise.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_fileset_get_staging(
+        remi_fileset_t fileset,
+        int* staging);
+
+/**
+ * @brief Sets how the target makes the data of this fileset durable
+ * before completing its migration (REMI_DURABILITY_DEFAULT by default,
+ * which lets the target provider decide, see remi_provider_set_durability).
+ * The policy the target applied is reported in the fileset's progress
+ * (see remi_fileset_get_progress) once the migration has completed.
+ *
+ * @param[in] fileset Fileset.
+ * @param[in] policy One of the REMI_DURABILITY_* values.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_fileset_set_durability(
+        remi_fileset_t fileset,
+        int policy);
+
+/**
+ * @brief Gets the durability policy requested for this fileset.
+ *
+ * @param[in] fileset Fileset.
+ * @param[out] policy One of the REMI_DURABILITY_* values.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_fileset_get_durability(
+        remi_fileset_t fileset,
+        int* policy);
+
 /**
  * @brief Registers a file in the fileset. The provided path
  * should be relative to the fileset's root. The file does not need
@@ -359,6 +517,37 @@ int remi_fileset_compute_size(
         int include_metadata,
         size_t* size);
 
+/**
+ * @brief Starts recording trace events (chunk reads, RPCs, writes,
+ * msync, callbacks) in the clients and providers of this process.
+ * Each execution stream records into its own ring buffer of the given
+ * capacity, overwriting its oldest events when full. The capacity is
+ * set by the first call; later calls clear the buffers.
+ *
+ * @param capacity Number of events kept per execution stream.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_trace_enable(size_t capacity);
+
+/**
+ * @brief Stops recording trace events.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_trace_disable(void);
+
+/**
+ * @brief Writes the recorded events to a file in the Chrome trace
+ * JSON format (readable by chrome://tracing and Perfetto). Tracing
+ * should be disabled before calling this function.
+ *
+ * @param filename Name of the file to write.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_trace_dump(const char* filename);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -67,6 +67,35 @@ int remi_provider_register(
         ABT_pool pool,
         remi_provider_t* provider);
 
+/**
+ * @brief Same as remi_provider_register but uses separate pools for the
+ * control RPCs (starting and ending migrations, status queries), the
+ * data RPCs (transfers and writes), and the background I/O work (e.g.
+ * flushes and preallocations, or the system calls of the
+ * REMI_IO_XSTREAM backend instead of a dedicated execution stream),
+ * so that control RPCs do not queue behind long transfers. Any of the
+ * pools may be ABT_POOL_NULL, in which case margo's default handler pool
+ * is used (the data pool for background I/O).
+ *
+ * @param[in] mid Margo instance.
+ * @param[in] abtio ABT-IO instance. May be ABT_IO_INSTANCE_NULL.
+ * @param[in] provider_id Provider id.
+ * @param[in] control_pool Argobots pool for control RPCs.
+ * @param[in] data_pool Argobots pool for data RPCs.
+ * @param[in] io_pool Argobots pool for background I/O.
+ * @param[out] provider Resulting provider.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_provider_register_with_pools(
+        margo_instance_id mid,
+        abt_io_instance_id abtio,
+        uint16_t provider_id,
+        ABT_pool control_pool,
+        ABT_pool data_pool,
+        ABT_pool io_pool,
+        remi_provider_t* provider);
+
 /**
  * @brief Destroys a REMI provider and deregisters its RPCs.
  *
@@ -121,6 +150,20 @@ int remi_provider_set_abt_io_instance(
         remi_provider_t provider,
         abt_io_instance_id abtio);
 
+/**
+ * @brief Selects the backend used to write files (REMI_IO_DEFAULT,
+ * REMI_IO_POSIX, REMI_IO_ABTIO, or REMI_IO_URING). This function
+ * should not be called while migrations are in progress.
+ *
+ * @param provider Provider.
+ * @param backend I/O backend.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_provider_set_io_backend(
+        remi_provider_t provider,
+        int backend);
+
 /**
  * @brief Registers a migration class by providing a callback
  * to call when a fileset of that class is migrated.
@@ -157,7 +200,9 @@ int remi_provider_register_provider_migration_class(
 
 /**
  * @brief Deregisters a migration class registered via
- * remi_provider_register_migration_class.
+ * remi_provider_register_migration_class. If "after" callbacks of
+ * the class are running on the callback pool, waits for them to
+ * return before freeing the class's arguments.
  */
 int remi_provider_deregister_migration_class(
         remi_provider_t provider,
@@ -172,11 +217,183 @@ int remi_provider_deregister_provider_migration_class(
         const char* class_name,
         uint16_t provider_id);
 
+/**
+ * @brief Sets how the provider makes migrated data durable before
+ * completing a migration, for filesets that do not request a policy
+ * themselves (see remi_fileset_set_durability):
+ * - REMI_DURABILITY_NONE: the data is left in the page cache;
+ * - REMI_DURABILITY_FDATASYNC (default): every file is fdatasync-ed,
+ *   the calls being issued in parallel through the I/O backend;
+ * - REMI_DURABILITY_SYNCFS: a single syncfs is issued per file system;
+ * - REMI_DURABILITY_WRITEBACK: writeback is started (sync_file_range)
+ *   as data arrives, and waited for at the end of the migration.
+ * The policy applied is reported to the client.
+ *
+ * @param provider Provider.
+ * @param policy One of the REMI_DURABILITY_* values except REMI_DURABILITY_DEFAULT.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_provider_set_durability(
+        remi_provider_t provider,
+        int policy);
+
+/**
+ * @brief Limits the rate at which the provider writes migrated data,
+ * in bytes per second and in write operations (chunks, or files for
+ * local migrations) per second. Writes exceeding the limits are delayed,
+ * not rejected. A limit of 0 means unlimited (the default). This function
+ * may be called at any time.
+ *
+ * @param provider Provider.
+ * @param bytes_per_sec Maximum bandwidth.
+ * @param ops_per_sec Maximum number of write operations per second.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_provider_set_rate_limit(
+        remi_provider_t provider,
+        uint64_t bytes_per_sec,
+        uint64_t ops_per_sec);
+
+/**
+ * @brief Limits the number of migrations the provider handles at the
+ * same time. Migrations beyond this limit wait, in the order in which
+ * they arrived, for another one to complete before they start. 0 means
+ * unlimited (the default). This function may be called at any time.
+ *
+ * @param provider Provider.
+ * @param max Maximum number of concurrent migrations.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_provider_set_max_concurrent_migrations(
+        remi_provider_t provider,
+        uint32_t max);
+
+/**
+ * @brief Sets how long a migration may go without any request from its
+ * client before the provider aborts it, removing the files it created
+ * and releasing its slot and the space reserved for it. This covers
+ * clients that fail or disappear in the middle of a migration. Expired
+ * migrations
+ * are looked for whenever a migration starts or waits for a slot.
+ * The default is 600 seconds; 0 disables the timeout.
+ *
+ * @param provider Provider.
+ * @param seconds Timeout in seconds.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_provider_set_operation_timeout(
+        remi_provider_t provider,
+        double seconds);
+
+/**
+ * @brief Allows the provider to read files under the given directory on
+ * behalf of clients, as it does when a client migrates files that the
+ * provider can see (REMI_USE_LOCAL). Files outside of the directories
+ * added with this function are never read by the provider; if none was
+ * added, such migrations fall back to transferring the files.
+ *
+ * @param provider Provider.
+ * @param root Directory whose files may be read.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_provider_add_source_root(
+        remi_provider_t provider,
+        const char* root);
+
+/**
+ * @brief Makes the provider run the "after" callbacks of migrations in
+ * the given pool instead of before replying to the client. The client
+ * is then answered as soon as the files are in place and durable, and
+ * the outcome of the callback can be polled with remi_get_callback_status.
+ * This only applies to migrations whose operation id the client knows;
+ * the callbacks of migrations done by the provider alone (REMI_USE_LOCAL),
+ * of batched migrations and of pulls still run before replying.
+ * Passing ABT_POOL_NULL restores synchronous callbacks (the default).
+ *
+ * @param provider Provider.
+ * @param pool Argobots pool in which to run the callbacks.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_provider_set_callback_pool(
+        remi_provider_t provider,
+        ABT_pool pool);
+
+/**
+ * @brief Enables deduplication of the files migrated with REMI_USE_DEDUP.
+ * The provider records the content hash of every such file it receives
+ * in an index persisted at index_path. A file whose hash is in the index
+ * is not transferred; it is instead cloned from the file the index points
+ * to, which requires a file system supporting reflinks (e.g. XFS, Btrfs).
+ * Setting allow_hardlinks to non-zero opts into aliasing: when cloning
+ * fails and the indexed file has the mode requested for the new one, the
+ * new file is created as a hard link to it. Both names then share the
+ * same content, so a write through one of them is seen through the other;
+ * only enable this when received files are never modified in place.
+ * Index entries whose file was modified since it was indexed are ignored,
+ * and the index file is compacted each time it is loaded. The files
+ * transferred are read back and hashed before being indexed; a migration
+ * whose files do not match the hashes sent by the client fails with
+ * REMI_ERR_MIGRATION.
+ *
+ * @param provider Provider.
+ * @param index_path Path of the index file, created if it does not exist.
+ * @param allow_hardlinks Whether files may be hard links to indexed files.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_provider_enable_dedup(
+        remi_provider_t provider,
+        const char* index_path,
+        int allow_hardlinks);
+
+/**
+ * @brief Gets the counters maintained by the provider since it was
+ * registered (migrations, bytes and files received, active operations,
+ * time spent in each phase, chunk handling latencies, I/O errors).
+ *
+ * @param[in] provider Provider.
+ * @param[out] stats Resulting counters.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_provider_get_stats(
+        remi_provider_t provider,
+        remi_stats_t* stats);
+
+/**
+ * @brief Same as remi_provider_get_stats but formats the counters as
+ * a JSON object. If buf is NULL, size is set to the size required to
+ * hold the string. Otherwise size should contain the number of bytes
+ * available in buf, and is set to the size of the string
+ * (including null-terminator).
+ *
+ * @param[in] provider Provider.
+ * @param[out] buf Buffer to hold the JSON string.
+ * @param[inout] size Size of the buffer/string.
+ *
+ * @return REMI_SUCCESS or error code defined in remi-common.h.
+ */
+int remi_provider_get_stats_json(
+        remi_provider_t provider,
+        char* buf,
+        size_t* size);
+
 /**
  * @brief Set the type of device for a given mount point. Calling this function
  * gives an opportunity for REMI to optimize transfers to files in this device,
  * .e.g by using locks that are specific to this device (not shared with other
- * devices), by restraining concurrency, etc.
+ * devices), by restraining concurrency, etc. Currently, writes to files on
+ * a REMI_DEVICE_HDD device are serialized. Files are matched to the device
+ * with the longest mount point containing them. This function should be
+ * called before migrations to the mount point start. The type of a mount
+ * point cannot be changed once set: setting it again to the same type
+ * succeeds, setting it to another type returns REMI_ERR_INVALID_ARG.
  *
  * @param mount_point Mount point of the device.
  * @param type Type of device (REMI_DEVICE_MEM, REMI_DEVICE_HDD, REMI_DEVICE_SSD).
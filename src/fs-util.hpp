@@ -7,11 +7,20 @@
 #define __FS_UTIL
 
 #include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <limits.h>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <iostream>
 #include <functional>
 #include <dirent.h>
+#include <string.h>
+#include <stdio.h>
 
 inline void mkdirs(const char *dir) {
     std::string tmp(dir);
@@ -34,7 +43,7 @@ void listFiles(const std::string& root, const std::string &path, F&& cb) {
     auto fullpath = root + "/" + path;
     if(auto dir = opendir(fullpath.c_str())) {
         while(auto f = readdir(dir)) {
-            if(!f->d_name || f->d_name[0] == '.') continue;
+            if(f->d_name[0] == '.') continue;
             if(f->d_type == DT_DIR) 
                 listFiles(root, path + f->d_name + "/", std::forward<F>(cb));
 
@@ -45,18 +54,116 @@ void listFiles(const std::string& root, const std::string &path, F&& cb) {
     }
 }
 
-inline void removeRec(const std::string &path) {
-    if(auto dir = opendir(path.c_str())) {
-        while(auto f = readdir(dir)) {
-            if(!f->d_name || f->d_name[0] == '.') continue;
-            if(f->d_type == DT_DIR) {
-                removeRec(path + f->d_name + "/");
-            } else {
-                remove((path+f->d_name).c_str());
-            }
+/**
+ * Removes name, relative to the directory open as dirfd (or AT_FDCWD),
+ * and everything below it if it is a directory. Entries are removed with
+ * unlinkat relative to their parent's file descriptor, so no path is
+ * ever built. Returns 0 on success, -1 if something could not be removed.
+ */
+inline int removeTreeAt(int dirfd, const char* name) {
+    if(unlinkat(dirfd, name, 0) == 0)
+        return 0;
+    if(errno == ENOENT)
+        return 0;
+    if(errno != EISDIR && errno != EPERM)
+        return -1;
+    int fd = openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+    if(fd == -1)
+        return -1;
+    DIR* dir = fdopendir(fd);
+    if(dir == nullptr) {
+        close(fd);
+        return -1;
+    }
+    int ret = 0;
+    while(auto f = readdir(dir)) {
+        if(strcmp(f->d_name, ".") == 0 || strcmp(f->d_name, "..") == 0) continue;
+        bool is_dir = f->d_type == DT_DIR;
+        if(f->d_type == DT_UNKNOWN) {
+            struct stat st;
+            is_dir = fstatat(fd, f->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
         }
-        closedir(dir);
+        if(is_dir) {
+            if(removeTreeAt(fd, f->d_name) != 0) ret = -1;
+        } else if(unlinkat(fd, f->d_name, 0) != 0 && errno != ENOENT) {
+            ret = -1;
+        }
+    }
+    closedir(dir); // also closes fd
+    if(unlinkat(dirfd, name, AT_REMOVEDIR) != 0 && errno != ENOENT)
+        ret = -1;
+    return ret;
+}
+
+/**
+ * Returns path if it exists, its closest existing ancestor otherwise.
+ */
+inline std::string existingAncestor(std::string path) {
+    struct stat st;
+    while(path.size() > 1 && stat(path.c_str(), &st) != 0) {
+        auto p = path.find_last_of('/', path.size() - 2);
+        if(p == std::string::npos)
+            return "/";
+        path.resize(p + 1);
+    }
+    return path.empty() ? "/" : path;
+}
+
+/**
+ * Renames from into to, failing with EEXIST instead of replacing to
+ * if it exists. Falls back to link+unlink on file systems that do not
+ * support RENAME_NOREPLACE. Returns 0 on success, -1 on error.
+ */
+inline int renameNoReplace(const char* from, const char* to) {
+#ifdef RENAME_NOREPLACE
+    if(renameat2(AT_FDCWD, from, AT_FDCWD, to, RENAME_NOREPLACE) == 0)
+        return 0;
+    if(errno != EINVAL && errno != ENOSYS)
+        return -1;
+#endif
+    if(link(from, to) != 0)
+        return -1;
+    unlink(from);
+    return 0;
+}
+
+inline void removeRec(const std::string &path) {
+    removeTreeAt(AT_FDCWD, path.c_str());
+}
+
+/**
+ * Copies size bytes from src_fd into dst_fd without going through
+ * user space when possible. A reflink (FICLONE) is tried first, then
+ * copy_file_range, then a plain read/write loop for file systems
+ * that support neither. Returns 0 on success, -1 on error.
+ */
+inline int copyFileContent(int src_fd, int dst_fd, size_t size) {
+    if(size == 0)
+        return 0;
+#ifdef FICLONE
+    if(ioctl(dst_fd, FICLONE, src_fd) == 0)
+        return 0;
+#endif
+    loff_t in_offset  = 0;
+    loff_t out_offset = 0;
+    while((size_t)out_offset < size) {
+        ssize_t s = copy_file_range(src_fd, &in_offset, dst_fd, &out_offset,
+                                    size - out_offset, 0);
+        if(s > 0) continue;
+        if(s == 0) return -1;
+        if(errno == EXDEV || errno == ENOSYS
+        || errno == EOPNOTSUPP || errno == EINVAL)
+            break;
+        return -1;
+    }
+    std::vector<char> buffer(1048576);
+    while((size_t)out_offset < size) {
+        size_t chunk = std::min(buffer.size(), size - (size_t)out_offset);
+        ssize_t r = pread(src_fd, buffer.data(), chunk, out_offset);
+        if(r <= 0) return -1;
+        if(pwrite(dst_fd, buffer.data(), r, out_offset) != r) return -1;
+        out_offset += r;
     }
-    remove(path.c_str());
+    return 0;
 }
 #endif
@@ -0,0 +1,115 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __REMI_AUTOTUNE_HPP
+#define __REMI_AUTOTUNE_HPP
+
+#include <cstddef>
+#include <algorithm>
+
+/**
+ * Transfer parameters found by the tuner for a given target.
+ */
+struct xfer_tuning {
+    size_t m_xfer_size      = 1048576;
+    size_t m_pipeline_depth = 2;
+};
+
+/**
+ * Hill-climbing tuner for the chunk size and pipeline depth of a
+ * chunked migration. The pipeline reports every chunk it sends along
+ * with the time it spent waiting for a free slot.
+ * Every s_window chunks, the tuner compares the throughput of the
+ * window with the best one seen so far: the chunk size keeps moving
+ * (doubling or halving) while throughput improves, and reverses
+ * direction otherwise, settling after two reversals. The pipeline depth
+ * grows when the sender mostly waits on RPCs, and shrinks back when it
+ * never does.
+ */
+class xfer_tuner {
+
+    static constexpr size_t s_min_xfer_size = 65536;
+    static constexpr size_t s_max_xfer_size = 67108864;
+    static constexpr size_t s_max_depth     = 8;
+    static constexpr size_t s_window        = 8;
+
+    xfer_tuning m_current;
+    xfer_tuning m_best;
+    double      m_best_throughput = 0.0;
+    bool        m_growing         = true;
+    unsigned    m_reversals       = 0;
+
+    size_t      m_chunks     = 0;
+    size_t      m_bytes      = 0;
+    double      m_start      = 0.0;
+    double      m_wait_time  = 0.0;
+
+    void adjust(double now) {
+        double elapsed = now - m_start;
+        if(elapsed <= 0.0) return;
+        double throughput = m_bytes / elapsed;
+
+        if(m_reversals < 2) {
+            if(throughput > m_best_throughput * 1.05) {
+                m_best_throughput = throughput;
+                m_best = m_current;
+            } else {
+                m_current.m_xfer_size = m_best.m_xfer_size;
+                m_growing = !m_growing;
+                m_reversals += 1;
+            }
+            if(m_reversals < 2) {
+                if(m_growing)
+                    m_current.m_xfer_size = std::min(m_current.m_xfer_size*2, s_max_xfer_size);
+                else
+                    m_current.m_xfer_size = std::max(m_current.m_xfer_size/2, s_min_xfer_size);
+            }
+        } else if(throughput > m_best_throughput) {
+            m_best_throughput = throughput;
+            m_best = m_current;
+        }
+
+        // the sender waits on RPCs more than it reads: more of them
+        // should be in flight; it never waits: fewer are enough
+        if(m_wait_time > 0.5 * elapsed && m_current.m_pipeline_depth < s_max_depth)
+            m_current.m_pipeline_depth += 1;
+        else if(m_wait_time < 0.05 * elapsed && m_current.m_pipeline_depth > 2)
+            m_current.m_pipeline_depth -= 1;
+        m_best.m_pipeline_depth = m_current.m_pipeline_depth;
+    }
+
+    public:
+
+    xfer_tuner(const xfer_tuning& initial, double now)
+    : m_current(initial), m_best(initial), m_start(now) {}
+
+    /* called once per chunk sent */
+    void record(size_t bytes, double wait_time, double now) {
+        m_chunks    += 1;
+        m_bytes     += bytes;
+        m_wait_time += wait_time;
+        if(m_chunks < s_window) return;
+        adjust(now);
+        m_chunks    = 0;
+        m_bytes     = 0;
+        m_wait_time = 0.0;
+        m_start     = now;
+    }
+
+    size_t xfer_size() const {
+        return m_current.m_xfer_size;
+    }
+
+    size_t pipeline_depth() const {
+        return m_current.m_pipeline_depth;
+    }
+
+    /* parameters to start the next migration to the same target with */
+    const xfer_tuning& best() const {
+        return m_best;
+    }
+};
+
+#endif
@@ -6,29 +6,248 @@
 #include "remi/remi-client.h"
 #include "remi/remi-server.h"
 #include <bedrock/AbstractComponent.hpp>
+#include <nlohmann/json.hpp>
 
 namespace tl = thallium;
+using json = nlohmann::json;
+
+static int parse_io_backend(const json& config) {
+    static const std::unordered_map<std::string, int> backends = {
+        {"default", REMI_IO_DEFAULT}, {"posix", REMI_IO_POSIX}, {"abt_io", REMI_IO_ABTIO},
+        {"io_uring", REMI_IO_URING}, {"xstream", REMI_IO_XSTREAM}
+    };
+    auto name = config.value("io_backend", std::string{"default"});
+    auto it = backends.find(name);
+    if(it == backends.end())
+        throw bedrock::Exception{"Invalid REMI io_backend \"{}\"", name};
+    return it->second;
+}
+
+static tl::pool get_pool(const bedrock::ComponentArgs& args, const char* name,
+                         const tl::pool& fallback = tl::pool()) {
+    auto it = args.dependencies.find(name);
+    if(it != args.dependencies.end() && !it->second.empty())
+        return it->second[0]->getHandle<tl::pool>();
+    return fallback;
+}
+
+static bedrock::Dependency pool_dependency(const char* name) {
+    return bedrock::Dependency{
+        /* name */ name,
+        /* type */ "pool",
+        /* is_required */ false,
+        /* is_array */ false,
+        /* is_updatable */ false
+    };
+}
+
+/* "rate_limit": { "bytes_per_sec": <number>, "ops_per_sec": <number> }, 0 meaning unlimited */
+static std::pair<uint64_t, uint64_t> parse_rate_limit(json& config) {
+    if(!config.contains("rate_limit"))
+        config["rate_limit"] = json::object();
+    auto& limit = config["rate_limit"];
+    if(!limit.is_object())
+        throw bedrock::Exception{"Invalid REMI rate_limit (expected an object)"};
+    limit["bytes_per_sec"] = limit.value("bytes_per_sec", (uint64_t)0);
+    limit["ops_per_sec"]   = limit.value("ops_per_sec", (uint64_t)0);
+    return { limit["bytes_per_sec"].get<uint64_t>(), limit["ops_per_sec"].get<uint64_t>() };
+}
+
+static json parse_config(const std::string& config) {
+    if(config.empty())
+        return json::object();
+    try {
+        return json::parse(config);
+    } catch(const json::exception& ex) {
+        throw bedrock::Exception{"Invalid REMI configuration: {}", ex.what()};
+    }
+}
+
+static json get_stats(int (*get_json)(void*, char*, size_t*), void* handle) {
+    size_t size = 0;
+    if(get_json(handle, nullptr, &size) != REMI_SUCCESS)
+        return json::object();
+    std::string stats(size, '\0');
+    if(get_json(handle, &stats[0], &size) != REMI_SUCCESS)
+        return json::object();
+    stats.resize(size-1);
+    return json::parse(stats);
+}
+
+/* settings of a receiver, read from its configuration before the
+   provider is registered so that an invalid one registers nothing */
+struct receiver_config {
+    std::vector<std::string>                  m_source_roots;
+    int                                       m_io_backend;
+    std::vector<std::pair<std::string, int>>  m_devices;
+    size_t                                    m_trace_capacity;
+    int                                       m_durability;
+    std::pair<uint64_t, uint64_t>             m_rate_limit;
+    uint32_t                                  m_max_migrations;
+    double                                    m_op_timeout;
+    bool                                      m_dedup = false;
+    std::string                               m_dedup_index;
+    bool                                      m_allow_hardlinks = false;
+};
+
+/* reads the settings of a receiver, filling config with their defaults */
+static receiver_config parse_receiver_config(json& config) {
+    receiver_config rc;
+
+    // "source_roots": directories whose files the provider may read for clients
+    if(!config.contains("source_roots"))
+        config["source_roots"] = json::array();
+    if(!config["source_roots"].is_array())
+        throw bedrock::Exception{"Invalid REMI source_roots (expected an array)"};
+    for(auto& root : config["source_roots"])
+        rc.m_source_roots.push_back(root.get<std::string>());
+
+    // "io_backend": "default", "posix", "abt_io", "io_uring" or "xstream"
+    rc.m_io_backend = parse_io_backend(config);
+    config["io_backend"] = config.value("io_backend", std::string{"default"});
+
+    // "devices": { "<mount point>": "mem", "hdd" or "ssd" }
+    static const std::unordered_map<std::string, int> device_types = {
+        {"mem", REMI_DEVICE_MEM}, {"hdd", REMI_DEVICE_HDD}, {"ssd", REMI_DEVICE_SSD}
+    };
+    if(!config.contains("devices"))
+        config["devices"] = json::object();
+    if(!config["devices"].is_object())
+        throw bedrock::Exception{"Invalid REMI devices (expected an object)"};
+    for(auto& dev : config["devices"].items()) {
+        auto type = dev.value().get<std::string>();
+        auto it = device_types.find(type);
+        if(it == device_types.end())
+            throw bedrock::Exception{"Invalid REMI device type \"{}\"", type};
+        rc.m_devices.emplace_back(dev.key(), it->second);
+    }
+
+    // "trace_capacity": number of events kept per execution stream, 0 to disable
+    rc.m_trace_capacity = config.value("trace_capacity", (size_t)0);
+    config["trace_capacity"] = rc.m_trace_capacity;
+
+    // "durability": "none", "fdatasync", "syncfs" or "writeback"
+    static const std::unordered_map<std::string, int> durability_policies = {
+        {"none", REMI_DURABILITY_NONE}, {"fdatasync", REMI_DURABILITY_FDATASYNC},
+        {"syncfs", REMI_DURABILITY_SYNCFS}, {"writeback", REMI_DURABILITY_WRITEBACK}
+    };
+    auto durability = config.value("durability", std::string{"fdatasync"});
+    auto durability_it = durability_policies.find(durability);
+    if(durability_it == durability_policies.end())
+        throw bedrock::Exception{"Invalid REMI durability \"{}\"", durability};
+    rc.m_durability = durability_it->second;
+    config["durability"] = durability;
+
+    rc.m_rate_limit = parse_rate_limit(config);
+
+    // "max_concurrent_migrations": 0 for unlimited
+    rc.m_max_migrations = config.value("max_concurrent_migrations", (uint32_t)0);
+    config["max_concurrent_migrations"] = rc.m_max_migrations;
+
+    // "operation_timeout": seconds without activity before a migration is aborted, 0 for none
+    rc.m_op_timeout = config.value("operation_timeout", 600.0);
+    if(rc.m_op_timeout < 0.0)
+        throw bedrock::Exception{"Invalid REMI operation_timeout {}", rc.m_op_timeout};
+    config["operation_timeout"] = rc.m_op_timeout;
+
+    // "dedup": { "index": "<path>", "allow_hardlinks": false }
+    if(config.contains("dedup")) {
+        auto& dedup = config["dedup"];
+        if(!dedup.is_object())
+            throw bedrock::Exception{"Invalid REMI dedup (expected an object)"};
+        rc.m_dedup = true;
+        rc.m_dedup_index = dedup.value("index", std::string{});
+        rc.m_allow_hardlinks = dedup.value("allow_hardlinks", false);
+        dedup["allow_hardlinks"] = rc.m_allow_hardlinks;
+    }
+    return rc;
+}
 
 class RemiReceiverComponent : public bedrock::AbstractComponent {
 
     remi_provider_t m_provider;
+    json            m_config;
+
+    /* applies the settings of the provider; it is destroyed by the
+       caller if one of them is refused */
+    void configure(const receiver_config& rc, const tl::pool& callback_pool) {
+        int ret;
+        for(auto& path : rc.m_source_roots) {
+            ret = remi_provider_add_source_root(m_provider, path.c_str());
+            if(ret != REMI_SUCCESS)
+                throw bedrock::Exception{"Invalid REMI source root \"{}\"", path};
+        }
+
+        // "callback_pool" dependency: run "after" callbacks asynchronously in it
+        if(callback_pool.native_handle() != ABT_POOL_NULL)
+            remi_provider_set_callback_pool(m_provider, callback_pool.native_handle());
+
+        ret = remi_provider_set_io_backend(m_provider, rc.m_io_backend);
+        if(ret != REMI_SUCCESS)
+            throw bedrock::Exception{
+                "Could not set REMI I/O backend: remi_provider_set_io_backend returned {}", ret};
+
+        remi_provider_set_durability(m_provider, rc.m_durability);
+        remi_provider_set_rate_limit(m_provider, rc.m_rate_limit.first, rc.m_rate_limit.second);
+        remi_provider_set_max_concurrent_migrations(m_provider, rc.m_max_migrations);
+        remi_provider_set_operation_timeout(m_provider, rc.m_op_timeout);
+
+        if(rc.m_dedup) {
+            ret = remi_provider_enable_dedup(m_provider, rc.m_dedup_index.c_str(), rc.m_allow_hardlinks);
+            if(ret != REMI_SUCCESS)
+                throw bedrock::Exception{
+                    "Could not enable REMI deduplication: remi_provider_enable_dedup returned {}", ret};
+        }
+
+        // devices and tracing are shared by the whole process, so they are set last
+        for(auto& dev : rc.m_devices) {
+            ret = remi_set_device(dev.first.c_str(), dev.second);
+            if(ret != REMI_SUCCESS)
+                throw bedrock::Exception{
+                    "Could not set REMI device \"{}\": remi_set_device returned {}", dev.first, ret};
+        }
+        if(rc.m_trace_capacity != 0)
+            remi_trace_enable(rc.m_trace_capacity);
+    }
 
     public:
 
     RemiReceiverComponent(const tl::engine& engine,
                           uint16_t  provider_id,
-                          const tl::pool& pool,
-                          abt_io_instance_id abtio)
+                          const tl::pool& control_pool,
+                          const tl::pool& data_pool,
+                          const tl::pool& io_pool,
+                          const tl::pool& callback_pool,
+                          abt_io_instance_id abtio,
+                          const json& config)
+    : m_config(config)
     {
-        int ret = remi_provider_register(
+        receiver_config rc;
+        try {
+            rc = parse_receiver_config(m_config);
+        } catch(const json::exception& ex) {
+            throw bedrock::Exception{"Invalid REMI receiver configuration: {}", ex.what()};
+        }
+
+        int ret = remi_provider_register_with_pools(
                 engine.get_margo_instance(),
                 abtio,
                 provider_id,
-                pool.native_handle(),
+                control_pool.native_handle(),
+                data_pool.native_handle(),
+                io_pool.native_handle(),
                 &m_provider);
         if(ret != REMI_SUCCESS)
             throw bedrock::Exception{
                 "Could not create REMI provider: remi_provider_register returned {}", ret};
+
+        // the destructor does not run if the constructor throws
+        try {
+            configure(rc, callback_pool);
+        } catch(...) {
+            remi_provider_destroy(m_provider);
+            throw;
+        }
     }
 
     ~RemiReceiverComponent() {
@@ -40,37 +259,42 @@ class RemiReceiverComponent : public bedrock::AbstractComponent {
     }
 
     std::string getConfig() override {
-        return "{}";
+        auto config = m_config;
+        config["stats"] = get_stats([](void* p, char* buf, size_t* size) {
+            return remi_provider_get_stats_json(static_cast<remi_provider_t>(p), buf, size);
+        }, m_provider);
+        return config.dump();
     }
 
     static std::shared_ptr<bedrock::AbstractComponent>
         Register(const bedrock::ComponentArgs& args) {
-            tl::pool pool;
-            auto it = args.dependencies.find("pool");
-            if(it != args.dependencies.end() && !it->second.empty()) {
-                pool = it->second[0]->getHandle<tl::pool>();
-            }
-            it = args.dependencies.find("abt_io");
+            // "pool" is used for any of control_pool and data_pool that is not provided
+            tl::pool pool         = get_pool(args, "pool");
+            tl::pool control_pool = get_pool(args, "control_pool", pool);
+            tl::pool data_pool    = get_pool(args, "data_pool", pool);
+            tl::pool io_pool      = get_pool(args, "io_pool");
+            tl::pool callback_pool = get_pool(args, "callback_pool");
+            auto it = args.dependencies.find("abt_io");
             abt_io_instance_id abt_io = ABT_IO_INSTANCE_NULL;
             if(it != args.dependencies.end() && !it->second.empty()) {
                 auto component = it->second[0]->getHandle<bedrock::ComponentPtr>();
                 abt_io = reinterpret_cast<abt_io_instance_id>(component->getHandle());
             }
+            json config = parse_config(args.config);
             return std::make_shared<RemiReceiverComponent>(
-                args.engine, args.provider_id, pool, abt_io);
+                args.engine, args.provider_id, control_pool, data_pool, io_pool, callback_pool,
+                abt_io, config);
         }
 
     static std::vector<bedrock::Dependency>
         GetDependencies(const bedrock::ComponentArgs& args) {
             (void)args;
             std::vector<bedrock::Dependency> dependencies{
-                bedrock::Dependency{
-                    /* name */ "pool",
-                    /* type */ "pool",
-                    /* is_required */ false,
-                    /* is_array */ false,
-                    /* is_updatable */ false
-                },
+                pool_dependency("pool"),
+                pool_dependency("control_pool"),
+                pool_dependency("data_pool"),
+                pool_dependency("io_pool"),
+                pool_dependency("callback_pool"),
                 bedrock::Dependency{
                     /* name */ "abt_io",
                     /* type */ "abt_io",
@@ -88,13 +312,73 @@ BEDROCK_REGISTER_COMPONENT_TYPE(remi_receiver, RemiReceiverComponent)
 class RemiSenderComponent : public bedrock::AbstractComponent {
 
     remi_client_t m_client;
+    json          m_config;
+
+    /* applies the settings of the client, filling m_config with their
+       defaults; the client is finalized by the caller if one is refused */
+    void configure(const tl::pool& io_pool) {
+        remi_client_set_io_pool(m_client, io_pool.native_handle());
+
+        // "io_backend": "default", "posix", "abt_io", "io_uring" or "xstream"
+        int ret = remi_client_set_io_backend(m_client, parse_io_backend(m_config));
+        if(ret != REMI_SUCCESS)
+            throw bedrock::Exception{
+                "Could not set REMI I/O backend: remi_client_set_io_backend returned {}", ret};
+        m_config["io_backend"] = m_config.value("io_backend", std::string{"default"});
+
+        // "default_mode": array of "mmap", "abtio", "zerocopy", "local"
+        static const std::unordered_map<std::string, int> mode_flags = {
+            {"mmap", REMI_USE_MMAP}, {"abtio", REMI_USE_ABTIO},
+            {"zerocopy", REMI_USE_ZEROCOPY}, {"local", REMI_USE_LOCAL}
+        };
+        if(!m_config.contains("default_mode"))
+            m_config["default_mode"] = json::array({"abtio"});
+        int mode = 0;
+        for(auto& flag : m_config["default_mode"]) {
+            auto it = mode_flags.find(flag.get<std::string>());
+            if(it == mode_flags.end())
+                throw bedrock::Exception{"Invalid REMI mode \"{}\"", flag.get<std::string>()};
+            mode |= it->second;
+        }
+        if(remi_client_set_default_mode(m_client, mode) != REMI_SUCCESS)
+            throw bedrock::Exception{"Invalid REMI default_mode"};
+
+        // "xfer_size": number of bytes, or "auto"
+        if(!m_config.contains("xfer_size"))
+            m_config["xfer_size"] = 1048576;
+        auto& xfer_size = m_config["xfer_size"];
+        if(xfer_size.is_string() && xfer_size.get<std::string>() == "auto")
+            remi_client_set_default_xfer_size(m_client, REMI_XFER_SIZE_AUTO);
+        else if(xfer_size.is_number_integer() && xfer_size.get<int64_t>() > 0)
+            remi_client_set_default_xfer_size(m_client, xfer_size.get<size_t>());
+        else
+            throw bedrock::Exception{"Invalid REMI xfer_size"};
+
+        // "pipeline_depth": number of chunk RPCs in flight
+        size_t depth = m_config.value("pipeline_depth", (size_t)2);
+        if(remi_client_set_pipeline_depth(m_client, depth) != REMI_SUCCESS)
+            throw bedrock::Exception{"Invalid REMI pipeline_depth {}", depth};
+        m_config["pipeline_depth"] = depth;
+
+        // "buffer_pool_size": number of chunk buffers kept across migrations
+        size_t buffer_pool_size = m_config.value("buffer_pool_size", (size_t)0);
+        remi_client_set_buffer_pool_size(m_client, buffer_pool_size);
+        m_config["buffer_pool_size"] = buffer_pool_size;
+
+        auto rate_limit = parse_rate_limit(m_config);
+        remi_client_set_rate_limit(m_client, rate_limit.first, rate_limit.second);
+    }
 
     public:
 
     RemiSenderComponent(const tl::engine& engine,
                         uint16_t  provider_id,
-                        abt_io_instance_id abtio)
+                        const tl::pool& io_pool,
+                        abt_io_instance_id abtio,
+                        const json& config)
+    : m_config(config)
     {
+        (void)provider_id;
         int ret = remi_client_init(
                 engine.get_margo_instance(),
                 abtio,
@@ -102,6 +386,17 @@ class RemiSenderComponent : public bedrock::AbstractComponent {
         if(ret != REMI_SUCCESS)
             throw bedrock::Exception{
                 "Could not create REMI provider: remi_client_init returned {}", ret};
+
+        // the destructor does not run if the constructor throws
+        try {
+            configure(io_pool);
+        } catch(const json::exception& ex) {
+            remi_client_finalize(m_client);
+            throw bedrock::Exception{"Invalid REMI sender configuration: {}", ex.what()};
+        } catch(...) {
+            remi_client_finalize(m_client);
+            throw;
+        }
     }
 
     ~RemiSenderComponent() {
@@ -113,7 +408,11 @@ class RemiSenderComponent : public bedrock::AbstractComponent {
     }
 
     std::string getConfig() override {
-        return "{}";
+        auto config = m_config;
+        config["stats"] = get_stats([](void* c, char* buf, size_t* size) {
+            return remi_client_get_stats_json(static_cast<remi_client_t>(c), buf, size);
+        }, m_client);
+        return config.dump();
     }
 
     static std::shared_ptr<bedrock::AbstractComponent>
@@ -124,14 +423,16 @@ class RemiSenderComponent : public bedrock::AbstractComponent {
                 auto component = it->second[0]->getHandle<bedrock::ComponentPtr>();
                 abt_io = reinterpret_cast<abt_io_instance_id>(component->getHandle());
             }
+            json config = parse_config(args.config);
             return std::make_shared<RemiSenderComponent>(
-                args.engine, args.provider_id, abt_io);
+                args.engine, args.provider_id, get_pool(args, "io_pool"), abt_io, config);
         }
 
     static std::vector<bedrock::Dependency>
         GetDependencies(const bedrock::ComponentArgs& args) {
             (void)args;
             std::vector<bedrock::Dependency> dependencies{
+                pool_dependency("io_pool"),
                 bedrock::Dependency{
                     /* name */ "abt_io",
                     /* type */ "abt_io",
@@ -13,14 +13,26 @@
 #include <sys/mman.h>
 #include <abt-io.h>
 #include <uuid/uuid.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <optional>
+#include <unordered_map>
 #include <thallium.hpp>
 #include <thallium/serialization/stl/pair.hpp>
 #include <thallium/serialization/stl/string.hpp>
 #include <thallium/serialization/stl/vector.hpp>
+#include <thallium/serialization/stl/tuple.hpp>
 #include "uuid-util.hpp"
 #include "fs-util.hpp"
 #include "remi/remi-client.h"
 #include "remi-fileset.hpp"
+#include "remi-io.hpp"
+#include "remi-autotune.hpp"
+#include "remi-stats.hpp"
+#include "remi-progress.hpp"
+#include "remi-trace.hpp"
+#include "remi-throttle.hpp"
 
 namespace tl = thallium;
 
@@ -32,23 +44,105 @@ struct remi_client {
     tl::remote_procedure m_migrate_start_rpc;
     tl::remote_procedure m_migrate_mmap_rpc;
     tl::remote_procedure m_migrate_write_rpc;
+    tl::remote_procedure m_migrate_bulk_write_rpc;
     tl::remote_procedure m_migrate_end_rpc;
+    tl::remote_procedure m_migrate_abort_rpc;
+    tl::remote_procedure m_migrate_local_rpc;
+    tl::remote_procedure m_migrate_status_rpc;
+    tl::remote_procedure m_pull_rpc;
+    tl::remote_procedure m_migrate_batch_rpc;
+    tl::remote_procedure m_callback_status_rpc;
     abt_io_instance_id   m_abtio = ABT_IO_INSTANCE_NULL;
+    int                  m_io_type = REMI_IO_DEFAULT;
+    tl::pool             m_io_pool; // declared before m_io, which uses it
+    std::shared_ptr<io_backend> m_io; // see current_io()
+    size_t               m_pipeline_depth = 2;
+    int                  m_default_mode = REMI_USE_ABTIO;
+    size_t               m_default_xfer_size = 1048576;
+    size_t               m_buffer_pool_size = 0;
+    std::vector<std::vector<char>> m_buffer_pool; // chunk buffers kept for reuse
+    tl::mutex            m_buffer_pool_mtx;
+    std::unordered_map<std::string, xfer_tuning> m_tunings; // tuned parameters per target
+    tl::mutex            m_tunings_mtx;
+    stats_counters       m_stats;
+    throttle             m_throttle;
+    priority_gate        m_priorities;
+    size_t               m_pending_removals = 0; // REMI_REMOVE_SOURCE_BACKGROUND removals
+    tl::mutex            m_removals_mtx;
+    tl::condition_variable m_removals_cv;
+    std::unordered_map<std::string, remi_provider_handle_t> m_handles; // cached handles per target
+    tl::mutex            m_handles_mtx; // also protects the handles' reference counts
 
     remi_client(tl::engine* e, abt_io_instance_id abtio)
     : m_engine(e)
     , m_migrate_start_rpc(m_engine->define("remi_migrate_start"))
     , m_migrate_mmap_rpc(m_engine->define("remi_migrate_mmap"))
     , m_migrate_write_rpc(m_engine->define("remi_migrate_write"))
+    , m_migrate_bulk_write_rpc(m_engine->define("remi_migrate_bulk_write"))
     , m_migrate_end_rpc(m_engine->define("remi_migrate_end"))
-    , m_abtio(abtio) {}
+    , m_migrate_abort_rpc(m_engine->define("remi_migrate_abort"))
+    , m_migrate_local_rpc(m_engine->define("remi_migrate_local"))
+    , m_migrate_status_rpc(m_engine->define("remi_migrate_status"))
+    , m_pull_rpc(m_engine->define("remi_pull"))
+    , m_migrate_batch_rpc(m_engine->define("remi_migrate_batch"))
+    , m_callback_status_rpc(m_engine->define("remi_callback_status"))
+    , m_abtio(abtio)
+    , m_io(make_io(REMI_IO_DEFAULT)) {}
 
+    /* pool in which source removals and background work run */
+    tl::pool work_pool() const {
+        return m_io_pool.native_handle() != ABT_POOL_NULL ?
+            m_io_pool : m_engine->get_handler_pool();
+    }
+
+    std::unique_ptr<io_backend> make_io(int type) const {
+        return make_io_backend(type, m_abtio, REMI_IO_XSTREAM, m_io_pool);
+    }
+
+    /* the I/O backend may be replaced while migrations are in progress,
+       so each migration keeps the one current when it started */
+    std::shared_ptr<io_backend> current_io() const {
+        return std::atomic_load(&m_io);
+    }
+
+    void set_io(std::unique_ptr<io_backend> io) {
+        std::atomic_store(&m_io, std::shared_ptr<io_backend>(std::move(io)));
+    }
+
+};
+
+/**
+ * RPC handle kept by a provider handle for one of the control RPCs, so
+ * that back-to-back migrations to the same provider reuse it instead of
+ * creating a new one each time. A call made while another ULT is using
+ * it goes through a new handle.
+ */
+struct warm_rpc {
+
+    tl::mutex                                    m_mutex;
+    std::optional<tl::callable_remote_procedure> m_call;
+
+    template<typename R, typename ... Args>
+    R call(const tl::remote_procedure& rpc, const tl::provider_handle& ph, Args&&... args) {
+        std::unique_lock<tl::mutex> lock(m_mutex, std::try_to_lock);
+        if(!lock.owns_lock())
+            return rpc.on(ph)(std::forward<Args>(args)...);
+        if(!m_call)
+            m_call.emplace(rpc.on(ph));
+        return (*m_call)(std::forward<Args>(args)...);
+    }
 };
 
 struct remi_provider_handle : public tl::provider_handle {
 
-    remi_client_t m_client    = nullptr;
-    uint64_t      m_ref_count = 0;
+    remi_client_t    m_client    = nullptr;
+    uint64_t         m_ref_count = 0;
+    bool             m_is_self   = false;
+    std::string      m_target;   // "<address>/<provider id>"
+    std::atomic<int> m_identity{0}; // 1 once known to be a REMI provider
+    tl::mutex        m_identity_mtx;
+    warm_rpc         m_start_call;
+    warm_rpc         m_end_call;
 
     template<typename ... Args>
     remi_provider_handle(Args&&... args)
@@ -71,6 +165,19 @@ extern "C" int remi_client_finalize(remi_client_t client)
 {
     if(client == REMI_CLIENT_NULL)
         return REMI_SUCCESS;
+    remi_client_wait_source_removals(client);
+    {
+        // drop the references the cache holds
+        std::lock_guard<tl::mutex> guard(client->m_handles_mtx);
+        for(auto& h : client->m_handles) {
+            h.second->m_ref_count -= 1;
+            if(h.second->m_ref_count == 0) {
+                client->m_num_providers -= 1;
+                delete h.second;
+            }
+        }
+        client->m_handles.clear();
+    }
     delete client->m_engine;
     delete client;
     return REMI_SUCCESS;
@@ -82,34 +189,168 @@ extern "C" int remi_client_set_abt_io_instance(
 {
     if(client) {
         client->m_abtio = abtio;
+        auto io = client->make_io(client->m_io_type);
+        if(io) client->set_io(std::move(io));
         return REMI_SUCCESS;
     } else {
         return REMI_ERR_INVALID_ARG;
     }
 }
 
+extern "C" int remi_client_set_io_backend(
+        remi_client_t client,
+        int backend)
+{
+    if(client == REMI_CLIENT_NULL)
+        return REMI_ERR_INVALID_ARG;
+    auto io = client->make_io(backend);
+    if(!io)
+        return REMI_ERR_INVALID_ARG;
+    client->m_io_type = backend;
+    client->set_io(std::move(io));
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_client_set_io_pool(
+        remi_client_t client,
+        ABT_pool pool)
+{
+    if(client == REMI_CLIENT_NULL)
+        return REMI_ERR_INVALID_ARG;
+    client->m_io_pool = tl::pool(pool);
+    auto io = client->make_io(client->m_io_type);
+    if(io) client->set_io(std::move(io));
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_client_set_default_mode(
+        remi_client_t client,
+        int mode)
+{
+    if(client == REMI_CLIENT_NULL || mode == REMI_USE_DEFAULT)
+        return REMI_ERR_INVALID_ARG;
+    client->m_default_mode = mode;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_client_set_default_xfer_size(
+        remi_client_t client,
+        size_t size)
+{
+    if(client == REMI_CLIENT_NULL)
+        return REMI_ERR_INVALID_ARG;
+    client->m_default_xfer_size = size;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_client_set_pipeline_depth(
+        remi_client_t client,
+        size_t depth)
+{
+    if(client == REMI_CLIENT_NULL || depth == 0)
+        return REMI_ERR_INVALID_ARG;
+    client->m_pipeline_depth = depth;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_client_set_buffer_pool_size(
+        remi_client_t client,
+        size_t count)
+{
+    if(client == REMI_CLIENT_NULL)
+        return REMI_ERR_INVALID_ARG;
+    std::lock_guard<tl::mutex> guard(client->m_buffer_pool_mtx);
+    client->m_buffer_pool_size = count;
+    if(client->m_buffer_pool.size() > count)
+        client->m_buffer_pool.resize(count);
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_client_set_rate_limit(
+        remi_client_t client,
+        uint64_t bytes_per_sec,
+        uint64_t ops_per_sec)
+{
+    if(client == REMI_CLIENT_NULL)
+        return REMI_ERR_INVALID_ARG;
+    client->m_throttle.m_bytes.set_rate(bytes_per_sec);
+    client->m_throttle.m_ops.set_rate(ops_per_sec);
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_client_wait_source_removals(remi_client_t client)
+{
+    if(client == REMI_CLIENT_NULL)
+        return REMI_ERR_INVALID_ARG;
+    std::unique_lock<tl::mutex> lock(client->m_removals_mtx);
+    client->m_removals_cv.wait(lock, [client]() { return client->m_pending_removals == 0; });
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_client_get_stats(
+        remi_client_t client,
+        remi_stats_t* stats)
+{
+    if(client == REMI_CLIENT_NULL || stats == NULL)
+        return REMI_ERR_INVALID_ARG;
+    client->m_stats.snapshot(stats);
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_client_get_stats_json(
+        remi_client_t client,
+        char* buf,
+        size_t* size)
+{
+    if(client == REMI_CLIENT_NULL || size == NULL)
+        return REMI_ERR_INVALID_ARG;
+    return copy_string_out(client->m_stats.to_json(), buf, size);
+}
+
 extern "C" int remi_provider_handle_create(
         remi_client_t client,
         hg_addr_t addr,
         uint16_t provider_id,
         remi_provider_handle_t* handle)
 {
+    // at most s_max_cached_handles handles are cached; when the cache is
+    // full, the handles that only the cache still references are dropped
+    static constexpr size_t s_max_cached_handles = 256;
     if(client == REMI_CLIENT_NULL)
         return REMI_ERR_INVALID_ARG;
-    auto theHandle = new remi_provider_handle(
-            tl::endpoint(*(client->m_engine), addr, false), provider_id);
-    try {
-        auto identity = theHandle->get_identity();
-        if(identity != "remi") {
-            delete theHandle;
-            return REMI_ERR_UNKNOWN_PR;
+    tl::endpoint ep(*(client->m_engine), addr, false);
+    auto target = static_cast<std::string>(ep) + "/" + std::to_string(provider_id);
+    // handles are cached, so that asking again for a provider the client
+    // already used costs neither a lookup nor a round trip
+    std::lock_guard<tl::mutex> guard(client->m_handles_mtx);
+    auto it = client->m_handles.find(target);
+    if(it != client->m_handles.end()) {
+        it->second->m_ref_count += 1;
+        *handle = it->second;
+        return REMI_SUCCESS;
+    }
+    if(client->m_handles.size() >= s_max_cached_handles) {
+        for(auto h = client->m_handles.begin(); h != client->m_handles.end(); ) {
+            if(h->second->m_ref_count != 1) {
+                ++h;
+                continue;
+            }
+            delete h->second;
+            client->m_num_providers -= 1;
+            h = client->m_handles.erase(h);
         }
-    } catch(...) {
-        delete theHandle;
-        return REMI_ERR_UNKNOWN_PR;
     }
+    bool cached = client->m_handles.size() < s_max_cached_handles;
+    auto theHandle = new remi_provider_handle(std::move(ep), provider_id);
     theHandle->m_client = client;
-    theHandle->m_ref_count = 1;
+    // one reference for the caller, one for the cache
+    theHandle->m_ref_count = cached ? 2 : 1;
+    // a provider living in this very process can always see our files
+    auto self = client->m_engine->self();
+    theHandle->m_is_self = margo_addr_cmp(client->m_mid, self.get_addr(), addr);
+    theHandle->m_target  = std::move(target);
+    if(cached)
+        client->m_handles[theHandle->m_target] = theHandle;
     *handle = theHandle;
     client->m_num_providers += 1;
     return REMI_SUCCESS;
@@ -119,14 +360,35 @@ extern "C" int remi_provider_handle_ref_incr(remi_provider_handle_t handle)
 {
     if(handle == REMI_PROVIDER_HANDLE_NULL)
         return REMI_ERR_INVALID_ARG;
+    std::lock_guard<tl::mutex> guard(handle->m_client->m_handles_mtx);
     handle->m_ref_count += 1;
     return REMI_SUCCESS;
 }
 
+/* checks that a handle refers to a REMI provider; only a successful check
+   is remembered, since a provider missing now may be started later */
+static int check_identity(remi_provider_handle_t ph)
+{
+    if(ph->m_identity == 1)
+        return REMI_SUCCESS;
+    std::lock_guard<tl::mutex> guard(ph->m_identity_mtx);
+    if(ph->m_identity == 1)
+        return REMI_SUCCESS;
+    try {
+        if(ph->get_identity() != "remi")
+            return REMI_ERR_UNKNOWN_PR;
+    } catch(...) {
+        return REMI_ERR_UNKNOWN_PR;
+    }
+    ph->m_identity = 1;
+    return REMI_SUCCESS;
+}
+
 extern "C" int remi_provider_handle_release(remi_provider_handle_t handle)
 {
     if(handle == REMI_PROVIDER_HANDLE_NULL)
         return REMI_SUCCESS;
+    std::lock_guard<tl::mutex> guard(handle->m_client->m_handles_mtx);
     handle->m_ref_count -= 1;
     if(handle->m_ref_count == 0) {
         handle->m_client->m_num_providers -= 1;
@@ -140,11 +402,151 @@ extern "C" int remi_shutdown_service(remi_client_t client, hg_addr_t addr)
     return margo_shutdown_remote_instance(client->m_mid, addr);
 }
 
+extern "C" int remi_fileset_set_progress_callback(
+        remi_fileset_t fileset,
+        remi_progress_callback_t callback,
+        void* uargs)
+{
+    if(fileset == REMI_FILESET_NULL)
+        return REMI_ERR_INVALID_ARG;
+    if(!fileset->m_progress)
+        fileset->m_progress = std::make_shared<migration_progress>();
+    fileset->m_progress->m_callback = callback;
+    fileset->m_progress->m_uargs    = uargs;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_fileset_get_progress(
+        remi_fileset_t fileset,
+        remi_progress_t* progress)
+{
+    if(fileset == REMI_FILESET_NULL || progress == NULL)
+        return REMI_ERR_INVALID_ARG;
+    if(!fileset->m_progress)
+        fileset->m_progress = std::make_shared<migration_progress>();
+    fileset->m_progress->snapshot(progress);
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_get_migration_status(
+        remi_provider_handle_t ph,
+        const char* operation_id,
+        remi_progress_t* progress)
+{
+    if(ph == REMI_PROVIDER_HANDLE_NULL
+    || operation_id == NULL
+    || progress == NULL)
+        return REMI_ERR_INVALID_ARG;
+    uuid theOperationId;
+    if(!uuid::from_string(operation_id, theOperationId))
+        return REMI_ERR_INVALID_OPID;
+    int ret = check_identity(ph);
+    if(ret != REMI_SUCCESS)
+        return ret;
+    // the response is in the form <errorcode, bytes total, bytes received,
+    // files total, files completed, seconds elapsed>
+    std::tuple<int32_t,uint64_t,uint64_t,uint64_t,uint64_t,double> result =
+        ph->m_client->m_migrate_status_rpc.on(*ph)(theOperationId);
+    ret = std::get<0>(result);
+    if(ret != REMI_SUCCESS)
+        return ret;
+    migration_progress::fill(progress, operation_id,
+            std::get<1>(result), std::get<2>(result), std::get<2>(result),
+            std::get<3>(result), std::get<4>(result), std::get<5>(result));
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_get_callback_status(
+        remi_provider_handle_t ph,
+        const char* operation_id,
+        int* status)
+{
+    if(ph == REMI_PROVIDER_HANDLE_NULL
+    || operation_id == NULL
+    || status == NULL)
+        return REMI_ERR_INVALID_ARG;
+    uuid theOperationId;
+    if(!uuid::from_string(operation_id, theOperationId))
+        return REMI_ERR_INVALID_OPID;
+    int ret = check_identity(ph);
+    if(ret != REMI_SUCCESS)
+        return ret;
+    // the response is in the form <errorcode, userstatus>
+    std::pair<int32_t,int32_t> result = ph->m_client->m_callback_status_rpc.on(*ph)(theOperationId);
+    *status = std::get<1>(result);
+    return std::get<0>(result);
+}
+
 static void list_existing_files(const char* filename, void* uargs) {
     auto files = static_cast<std::set<std::string>*>(uargs);
     files->emplace(filename);
 }
 
+static size_t total_size(const std::vector<std::size_t>& sizes)
+{
+    size_t total = 0;
+    for(auto s : sizes)
+        total += s;
+    return total;
+}
+
+/* sources of a migration, to be removed once it has completed */
+struct source_removal {
+    std::string              m_root;
+    std::vector<std::string> m_files;
+    std::vector<std::string> m_directories;
+};
+
+/* removes the sources of a migration with unlinkat relative to the
+   fileset's root, spreading the calls over several ULTs of the client's
+   work pool (which run in parallel if the pool has several xstreams) */
+static void remove_sources(remi_client_t client, const source_removal& removal)
+{
+    static constexpr size_t s_removal_ults = 16;
+    int rootfd = open(removal.m_root.c_str(), O_RDONLY | O_DIRECTORY);
+    if(rootfd == -1)
+        return;
+    auto pool = client->work_pool();
+    // files first, so the directories are mostly empty by the time they are removed
+    parallel_io(pool, removal.m_files.size(), s_removal_ults, [&](size_t i) {
+        unlinkat(rootfd, removal.m_files[i].c_str(), 0);
+    });
+    parallel_io(pool, removal.m_directories.size(), s_removal_ults, [&](size_t i) {
+        removeTreeAt(rootfd, removal.m_directories[i].c_str());
+    });
+    close(rootfd);
+}
+
+/* tells the provider to drop a migration that failed before it could be
+   ended, so that the slot and space it holds are released right away
+   rather than when it expires; the provider may have dropped it already */
+static void abort_migration(remi_provider_handle_t ph, const uuid& operation_id)
+{
+    try {
+        ph->m_client->m_migrate_abort_rpc.on(*ph)(operation_id);
+    } catch(...) {}
+}
+
+static void begin_progress(remi_fileset_t fileset, const std::vector<std::size_t>& sizes)
+{
+    fileset->m_progress->begin(sizes.size(),
+            std::count(sizes.begin(), sizes.end(), 0), total_size(sizes));
+}
+
+static int migrate_using_local(
+        remi_provider_handle_t ph,
+        remi_fileset_t fileset,
+        const std::set<std::string>& files,
+        const std::string& remote_root,
+        int remove_source,
+        int* status);
+
+static void remove_fileset_sources(
+        remi_client_t client,
+        remi_fileset_t fileset,
+        const std::set<std::string>& files,
+        int remove_source);
+
 static int migrate_using_mmap(
         remi_provider_handle_t ph,
         remi_fileset_t fileset,
@@ -153,14 +555,16 @@ static int migrate_using_mmap(
         int* status);
 
 static int migrate_using_abtio(
-        remi_provider_handle_t ph,
+        const std::vector<remi_provider_handle_t>& stripes,
         remi_fileset_t fileset,
         const std::set<std::string>& files,
         const std::string& remote_root,
+        int mode,
         int* status);
 
-extern "C" int remi_fileset_migrate(
-        remi_provider_handle_t ph,
+/* migrates through stripes[0], spreading chunks over all the stripes */
+static int migrate_fileset(
+        const std::vector<remi_provider_handle_t>& stripes,
         remi_fileset_t fileset,
         const char* remote_root,
         int remove_source,
@@ -169,27 +573,55 @@ extern "C" int remi_fileset_migrate(
 {
     int ret;
 
-    if(ph == REMI_PROVIDER_HANDLE_NULL
-    || fileset == REMI_FILESET_NULL
+    if(fileset == REMI_FILESET_NULL
     || remote_root == NULL)
         return REMI_ERR_INVALID_ARG;
     if(remote_root[0] != '/')
         return REMI_ERR_INVALID_ARG;
 
+    for(auto h : stripes) {
+        ret = check_identity(h);
+        if(ret != REMI_SUCCESS)
+            return ret;
+    }
+
+    auto ph = stripes[0];
+
     std::string theRemoteRoot(remote_root);
     if(theRemoteRoot[theRemoteRoot.size()-1] != '/')
         theRemoteRoot += "/";
 
+    if(mode == REMI_USE_DEFAULT)
+        mode = ph->m_client->m_default_mode;
+
     // find the set of files to migrate from the fileset
     std::set<std::string> files;
     remi_fileset_walkthrough(fileset, list_existing_files,
             static_cast<void*>(&files));
 
-    if(mode == REMI_USE_MMAP) {
-        ret = migrate_using_mmap(ph, fileset, files, theRemoteRoot.c_str(), status);
-    } else {
-        ret = migrate_using_abtio(ph, fileset, files, theRemoteRoot.c_str(), status);
+    auto& stats = ph->m_client->m_stats;
+    stats.m_active_operations += 1;
+    // the fileset's progress is created on demand so that it can be polled
+    if(!fileset->m_progress)
+        fileset->m_progress = std::make_shared<migration_progress>();
+
+    ret = REMI_ERR_NOT_LOCAL;
+    if((mode & REMI_USE_LOCAL) || ph->m_is_self) {
+        ret = migrate_using_local(ph, fileset, files, theRemoteRoot, remove_source, status);
     }
+    // fall back to a transfer if the target could not see our files
+    if(ret == REMI_ERR_NOT_LOCAL) {
+        if(mode & REMI_USE_MMAP) {
+            ret = migrate_using_mmap(ph, fileset, files, theRemoteRoot.c_str(), status);
+        } else {
+            ret = migrate_using_abtio(stripes, fileset, files, theRemoteRoot.c_str(), mode, status);
+        }
+    }
+
+    stats.m_active_operations -= 1;
+    if(ret != REMI_SUCCESS || *status != 0)
+        stats.m_failed_migrations += 1;
+    fileset->m_progress->finished(ret == REMI_SUCCESS && *status == 0);
 
     if(ret != REMI_SUCCESS) {
         return ret;
@@ -199,20 +631,339 @@ extern "C" int remi_fileset_migrate(
         return REMI_ERR_USER;
     }
 
-    if(remove_source == REMI_REMOVE_SOURCE) {
-        for(auto& filename : files) {
-            auto theFilename = fileset->m_root + filename;
-            remove(theFilename.c_str());
+    stats.m_migrations += 1;
+    stats.m_files_migrated += files.size();
+
+    remove_fileset_sources(ph->m_client, fileset, files, remove_source);
+
+    return REMI_SUCCESS;
+}
+
+/* removes the source files of a migrated fileset as remove_source requests */
+static void remove_fileset_sources(
+        remi_client_t client,
+        remi_fileset_t fileset,
+        const std::set<std::string>& files,
+        int remove_source)
+{
+    if(remove_source == REMI_KEEP_SOURCE)
+        return;
+    auto removal = std::make_shared<source_removal>();
+    removal->m_root = fileset->m_root;
+    removal->m_files.assign(files.begin(), files.end());
+    removal->m_directories.assign(fileset->m_directories.begin(), fileset->m_directories.end());
+    if(remove_source == REMI_REMOVE_SOURCE_BACKGROUND) {
+        {
+            std::lock_guard<tl::mutex> guard(client->m_removals_mtx);
+            client->m_pending_removals += 1;
         }
-        for(auto& dirname : fileset->m_directories) {
-            auto theDirname = fileset->m_root + dirname;
-            removeRec(theDirname);
+        client->work_pool().make_thread([client, removal]() {
+            remove_sources(client, *removal);
+            {
+                std::lock_guard<tl::mutex> guard(client->m_removals_mtx);
+                client->m_pending_removals -= 1;
+            }
+            client->m_removals_cv.notify_all();
+        }, tl::anonymous());
+    } else {
+        remove_sources(client, *removal);
+    }
+}
+
+extern "C" int remi_fileset_migrate(
+        remi_provider_handle_t ph,
+        remi_fileset_t fileset,
+        const char* remote_root,
+        int remove_source,
+        int mode,
+        int* status)
+{
+    if(ph == REMI_PROVIDER_HANDLE_NULL)
+        return REMI_ERR_INVALID_ARG;
+    return migrate_fileset({ph}, fileset, remote_root, remove_source, mode, status);
+}
+
+extern "C" int remi_fileset_migrate_striped(
+        remi_provider_handle_t* handles,
+        size_t count,
+        remi_fileset_t fileset,
+        const char* remote_root,
+        int remove_source,
+        int mode,
+        int* status)
+{
+    if(handles == nullptr || count == 0)
+        return REMI_ERR_INVALID_ARG;
+    std::vector<remi_provider_handle_t> stripes(handles, handles + count);
+    for(auto h : stripes) {
+        if(h == REMI_PROVIDER_HANDLE_NULL || h->m_client != stripes[0]->m_client)
+            return REMI_ERR_INVALID_ARG;
+    }
+    return migrate_fileset(stripes, fileset, remote_root, remove_source, mode, status);
+}
+
+/* a fileset small enough for its content to go in a migrate_batch RPC */
+struct batch_entry {
+    size_t                         m_index = 0; // in the caller's arrays
+    std::set<std::string>          m_files;
+    std::vector<std::size_t>       m_sizes;
+    std::vector<mode_t>            m_modes;
+    std::vector<std::vector<char>> m_data;
+    size_t                         m_bytes = 0;
+};
+
+/* reads the files of a batch entry, returns false if one of them cannot
+   be read or if they hold more than max_bytes */
+static bool read_batch_entry(io_backend& io, const std::string& root,
+                             batch_entry& entry, size_t max_bytes)
+{
+    for(auto& filename : entry.m_files) {
+        auto theFilename = root + filename;
+        int fd = open(theFilename.c_str(), O_RDONLY, 0);
+        if(fd == -1)
+            return false;
+        struct stat st;
+        if(fstat(fd, &st) != 0 || entry.m_bytes + st.st_size > max_bytes) {
+            close(fd);
+            return false;
         }
+        std::vector<char> data(st.st_size);
+        size_t read_size = read_chunk(io, fd, data.data(), data.size(), 0);
+        close(fd);
+        if(read_size != data.size())
+            return false;
+        entry.m_bytes += data.size();
+        entry.m_sizes.push_back(data.size());
+        entry.m_modes.push_back(st.st_mode);
+        entry.m_data.push_back(std::move(data));
     }
+    return true;
+}
 
+extern "C" int remi_fileset_migrate_batch(
+        remi_provider_handle_t ph,
+        remi_fileset_t* filesets,
+        const char** remote_roots,
+        size_t count,
+        int remove_source,
+        int mode,
+        int* statuses,
+        int* results)
+{
+    // filesets up to s_inline_size are sent along with their content,
+    // in RPCs of up to s_batch_size bytes
+    static constexpr size_t s_inline_size = 256*1024;
+    static constexpr size_t s_batch_size  = 8*1024*1024;
+
+    if(ph == REMI_PROVIDER_HANDLE_NULL)
+        return REMI_ERR_INVALID_ARG;
+    if(count != 0 && (filesets == nullptr || remote_roots == nullptr
+                   || statuses == nullptr || results == nullptr))
+        return REMI_ERR_INVALID_ARG;
+    int ret = check_identity(ph);
+    if(ret != REMI_SUCCESS)
+        return ret;
+
+    auto client = ph->m_client;
+    auto& stats = client->m_stats;
+    if(mode == REMI_USE_DEFAULT)
+        mode = client->m_default_mode;
+
+    // the response holds a pair <errorcode, userstatus> per fileset
+    std::vector<batch_entry> batch;
+    size_t batch_bytes = 0;
+    auto send_batch = [&]() {
+        if(batch.empty())
+            return;
+        std::vector<std::tuple<remi_fileset, std::vector<std::size_t>,
+                               std::vector<mode_t>, std::vector<std::vector<char>>>> args;
+        // the batch goes out at the highest priority of its filesets
+        int32_t priority = filesets[batch.front().m_index]->m_priority;
+        for(auto& entry : batch) {
+            auto fileset = filesets[entry.m_index];
+            priority = std::max(priority, fileset->m_priority);
+            remi_fileset remote = *fileset;
+            remote.m_files = entry.m_files;
+            remote.m_directories = decltype(remote.m_directories)();
+            remote.m_root = remote_roots[entry.m_index];
+            if(remote.m_root[remote.m_root.size()-1] != '/')
+                remote.m_root += "/";
+            remote.m_progress.reset();
+            args.emplace_back(std::move(remote), entry.m_sizes, entry.m_modes, std::move(entry.m_data));
+        }
+        stats.m_active_operations += batch.size();
+        std::vector<std::pair<int32_t,int32_t>> replies;
+        {
+            priority_slot prio(client->m_priorities, priority);
+            client->m_throttle.acquire(*client->m_engine, batch_bytes);
+            replies = client->m_migrate_batch_rpc.on(*ph)(args)
+                        .as<std::vector<std::pair<int32_t,int32_t>>>();
+        }
+        stats.m_active_operations -= batch.size();
+        for(size_t k = 0; k < batch.size(); k++) {
+            auto& entry = batch[k];
+            auto fileset = filesets[entry.m_index];
+            int32_t r = k < replies.size() ? replies[k].first : REMI_ERR_MIGRATION;
+            if(r == REMI_ERR_USER)
+                statuses[entry.m_index] = replies[k].second;
+            results[entry.m_index]  = r;
+            if(r == REMI_SUCCESS) {
+                fileset->m_progress->sent(entry.m_bytes);
+                fileset->m_progress->acked(entry.m_bytes, entry.m_files.size()
+                        - std::count(entry.m_sizes.begin(), entry.m_sizes.end(), 0));
+                stats.m_migrations += 1;
+                stats.m_files_migrated += entry.m_files.size();
+                stats.m_bytes_migrated += entry.m_bytes;
+                remove_fileset_sources(client, fileset, entry.m_files, remove_source);
+            } else {
+                stats.m_failed_migrations += 1;
+            }
+            fileset->m_progress->finished(r == REMI_SUCCESS);
+        }
+        batch.clear();
+        batch_bytes = 0;
+    };
+
+    // filesets that are too large, or that the provider could read itself,
+    // are migrated on their own
+    std::vector<size_t> individual;
+    for(size_t i = 0; i < count; i++) {
+        statuses[i] = 0;
+        results[i]  = REMI_SUCCESS;
+        auto fileset = filesets[i];
+        if(fileset == REMI_FILESET_NULL || remote_roots[i] == NULL || remote_roots[i][0] != '/') {
+            results[i] = REMI_ERR_INVALID_ARG;
+            continue;
+        }
+        if((mode & REMI_USE_LOCAL) || ph->m_is_self) {
+            individual.push_back(i);
+            continue;
+        }
+        batch_entry entry;
+        entry.m_index = i;
+        remi_fileset_walkthrough(fileset, list_existing_files, static_cast<void*>(&entry.m_files));
+        if(!read_batch_entry(*client->current_io(), fileset->m_root, entry, s_inline_size)) {
+            individual.push_back(i);
+            continue;
+        }
+        if(!fileset->m_progress)
+            fileset->m_progress = std::make_shared<migration_progress>();
+        begin_progress(fileset, entry.m_sizes);
+        if(batch_bytes + entry.m_bytes > s_batch_size)
+            send_batch();
+        batch_bytes += entry.m_bytes;
+        batch.push_back(std::move(entry));
+    }
+    send_batch();
+
+    for(auto i : individual)
+        results[i] = remi_fileset_migrate(ph, filesets[i], remote_roots[i], remove_source, mode, &statuses[i]);
+
+    for(size_t i = 0; i < count; i++) {
+        if(results[i] != REMI_SUCCESS)
+            return results[i];
+    }
     return REMI_SUCCESS;
 }
 
+extern "C" int remi_fileset_pull(
+        remi_provider_handle_t ph,
+        const char* source_address,
+        uint16_t source_provider_id,
+        remi_fileset_t fileset,
+        const char* local_root,
+        int* status)
+{
+    if(ph == REMI_PROVIDER_HANDLE_NULL
+    || source_address == NULL
+    || fileset == REMI_FILESET_NULL
+    || local_root == NULL
+    || local_root[0] != '/')
+        return REMI_ERR_INVALID_ARG;
+
+    int ret = check_identity(ph);
+    if(ret != REMI_SUCCESS)
+        return ret;
+
+    std::string theLocalRoot(local_root);
+    if(theLocalRoot[theLocalRoot.size()-1] != '/')
+        theLocalRoot += "/";
+
+    // the response is in the form <errorcode, userstatus, durability>
+    std::tuple<int32_t, int32_t, int32_t> result = ph->m_client->m_pull_rpc.on(*ph)(
+            *fileset, std::string(source_address), source_provider_id, theLocalRoot);
+    *status = std::get<1>(result);
+    return std::get<0>(result);
+}
+
+int migrate_using_local(
+        remi_provider_handle_t ph,
+        remi_fileset_t fileset,
+        const std::set<std::string>& files,
+        const std::string& remote_root,
+        int remove_source,
+        int* status)
+{
+    std::vector<std::size_t> theSizes;
+    std::vector<mode_t> theModes;
+    std::vector<std::pair<uint64_t,uint64_t>> theIdentities; // <inode, mtime in ns>
+
+    for(auto& filename : files) {
+        auto theFilename = fileset->m_root + filename;
+        struct stat st;
+        if(0 != stat(theFilename.c_str(), &st))
+            return REMI_ERR_UNKNOWN_FILE;
+        theSizes.push_back(st.st_size);
+        theModes.push_back(st.st_mode);
+        theIdentities.emplace_back(st.st_ino,
+                (uint64_t)st.st_mtim.tv_sec*1000000000 + st.st_mtim.tv_nsec);
+    }
+
+    begin_progress(fileset, theSizes);
+
+    // create a copy of the fileset where m_directory is empty
+    // and the filenames in directories have been resolved
+    auto tmp_files = std::move(fileset->m_files);
+    auto tmp_dirs  = std::move(fileset->m_directories);
+    auto tmp_root  = std::move(fileset->m_root);
+    fileset->m_files = files;
+    fileset->m_directories = decltype(fileset->m_directories)();
+    fileset->m_root = remote_root;
+
+    // call migrate_local RPC, the provider does the whole migration
+    // the response is in the form <errorcode, userstatus, durability>
+    double t_transfer;
+    std::tuple<int32_t, int32_t, int32_t> local_call_result;
+    {
+        priority_slot prio(ph->m_client->m_priorities, fileset->m_priority);
+        ph->m_client->m_throttle.acquire(*ph->m_client->m_engine, total_size(theSizes));
+        t_transfer = tl::timer::wtime();
+        local_call_result = ph->m_client->m_migrate_local_rpc.on(*ph)(
+                *fileset, tmp_root, theSizes, theModes, theIdentities,
+                (int32_t)remove_source);
+    }
+
+    // put back the fileset's original members
+    fileset->m_root        = std::move(tmp_root);
+    fileset->m_files       = std::move(tmp_files);
+    fileset->m_directories = std::move(tmp_dirs);
+
+    int ret = std::get<0>(local_call_result);
+    if(ret == REMI_ERR_USER) {
+        *status = std::get<1>(local_call_result);
+    } else {
+        *status = 0;
+    }
+    fileset->m_progress->durable(std::get<2>(local_call_result));
+
+    if(ret != REMI_ERR_NOT_LOCAL)
+        ph->m_client->m_stats.record_phase(REMI_PHASE_TRANSFER, tl::timer::wtime() - t_transfer);
+    if(ret == REMI_SUCCESS)
+        ph->m_client->m_stats.m_bytes_migrated += total_size(theSizes);
+
+    return ret;
+}
+
 int migrate_using_mmap(
         remi_provider_handle_t ph,
         remi_fileset_t fileset,
@@ -276,6 +1027,8 @@ int migrate_using_mmap(
     if(theData.size() != 0) 
         localBulk = ph->m_client->m_engine->expose(theData, tl::bulk_mode::read_only);
 
+    begin_progress(fileset, theSizes);
+
     // create a copy of the fileset where m_directory is empty
     // and the filenames in directories have been resolved
     auto tmp_files = std::move(fileset->m_files);
@@ -286,9 +1039,13 @@ int migrate_using_mmap(
     fileset->m_root = remote_root;
 
     // call migrate_start RPC
-    // the response is in the form <errorcode, userstatus, uuid>
-    std::tuple<int32_t, int32_t, uuid> start_call_result 
-        = ph->m_client->m_migrate_start_rpc.on(*ph)(*fileset, theSizes, theModes);
+    // the response is in the form <errorcode, userstatus, uuid, deduplicated files>
+    double t_start = tl::timer::wtime();
+    std::tuple<int32_t, int32_t, uuid, std::vector<uint32_t>> start_call_result
+        = ph->m_start_call.call<std::tuple<int32_t, int32_t, uuid, std::vector<uint32_t>>>(
+                ph->m_client->m_migrate_start_rpc, *ph, *fileset, theSizes, theModes,
+                std::vector<std::string>());
+    ph->m_client->m_stats.record_phase(REMI_PHASE_START, tl::timer::wtime() - t_start);
     int ret = std::get<0>(start_call_result);
     if(ret != REMI_SUCCESS) {
         cleanup();
@@ -297,9 +1054,19 @@ int migrate_using_mmap(
         return ret;
     }
     auto& operation_id = std::get<2>(start_call_result);
+    fileset->m_progress->started(operation_id.to_string());
 
     // send the migrate_mmap RPC
-    ret = ph->m_client->m_migrate_mmap_rpc.on(*ph)(operation_id, localBulk);
+    double t_transfer;
+    {
+        priority_slot prio(ph->m_client->m_priorities, fileset->m_priority);
+        ph->m_client->m_throttle.acquire(*ph->m_client->m_engine, total_size(theSizes));
+        t_transfer = tl::timer::wtime();
+        trace("mmap_rpc", 'b', operation_id, 0, 0, total_size(theSizes));
+        ret = ph->m_client->m_migrate_mmap_rpc.on(*ph)(operation_id, localBulk);
+        trace("mmap_rpc", 'e', operation_id, 0, 0, total_size(theSizes));
+    }
+    ph->m_client->m_stats.record_phase(REMI_PHASE_TRANSFER, tl::timer::wtime() - t_transfer);
 
     // put back the fileset's original members
     fileset->m_root        = std::move(tmp_root);
@@ -307,42 +1074,55 @@ int migrate_using_mmap(
     fileset->m_directories = std::move(tmp_dirs);
 
     if(ret != REMI_SUCCESS) {
+        abort_migration(ph, operation_id);
         cleanup();
         return ret;
     }
 
     // xfer went ok, now send migrate_end rpc.
-    // the response is in the form <errorcode, userstatus>
-    std::pair<int32_t, int32_t> end_call_result =
-        ph->m_client->m_migrate_end_rpc.on(*ph)(operation_id);
+    // the response is in the form <errorcode, userstatus, durability>
+    double t_end = tl::timer::wtime();
+    std::tuple<int32_t, int32_t, int32_t> end_call_result =
+        ph->m_end_call.call<std::tuple<int32_t, int32_t, int32_t>>(
+                ph->m_client->m_migrate_end_rpc, *ph, operation_id);
+    ph->m_client->m_stats.record_phase(REMI_PHASE_END, tl::timer::wtime() - t_end);
 
     cleanup();
 
-    ret = end_call_result.first;
+    ret = std::get<0>(end_call_result);
     if(ret == REMI_ERR_USER) {
-        *status = end_call_result.second;
+        *status = std::get<1>(end_call_result);
     } else {
         *status = 0;
     }
+    fileset->m_progress->durable(std::get<2>(end_call_result));
+
+    if(ret == REMI_SUCCESS)
+        ph->m_client->m_stats.m_bytes_migrated += total_size(theSizes);
 
     return ret;
 }
 
 int migrate_using_abtio(
-        remi_provider_handle_t ph,
+        const std::vector<remi_provider_handle_t>& stripes,
         remi_fileset_t fileset,
         const std::set<std::string>& files,
         const std::string& remote_root,
+        int mode,
         int* status)
 {
+    auto ph = stripes[0];
     // expose the data
     std::vector<int> openedFileDescriptors;
     std::vector<std::pair<void*,std::size_t>> theData;
     std::vector<std::size_t> theSizes;
     std::vector<mode_t> theModes;
 
-    auto cleanup = [&openedFileDescriptors]() {
+    auto io = ph->m_client->current_io();
+
+    auto cleanup = [&openedFileDescriptors, &io]() {
         for(auto& fd : openedFileDescriptors) {
+            io->deregister_file(fd);
             close(fd);
         }
     };
@@ -357,6 +1137,7 @@ int migrate_using_abtio(
             return REMI_ERR_UNKNOWN_FILE;
         }
         openedFileDescriptors.push_back(fd);
+        io->register_file(fd);
         // get file size
         struct stat st;
         if(0 != fstat(fd, &st)) {
@@ -369,6 +1150,18 @@ int migrate_using_abtio(
         theModes.push_back(mode);
     }
 
+    // with REMI_USE_DEDUP, send the hash of each file so the provider
+    // can skip those whose content it already has
+    std::vector<std::string> theHashes;
+    if(mode & REMI_USE_DEDUP) {
+        theHashes.resize(openedFileDescriptors.size());
+        parallel_io(ph->m_client->work_pool(), theHashes.size(), 16, [&](size_t i) {
+            theHashes[i] = hash_file(*io, openedFileDescriptors[i], theSizes[i]);
+        });
+    }
+
+    begin_progress(fileset, theSizes);
+
     // create a copy of the fileset where m_directory is empty
     // and the filenames in directories have been resolved
     auto tmp_files = std::move(fileset->m_files);
@@ -379,9 +1172,17 @@ int migrate_using_abtio(
     fileset->m_root = remote_root;
 
     // call migrate_start RPC
-    // the response is in the form <errorcode, userstatus, uuid>
-    std::tuple<int32_t, int32_t, uuid> start_call_result 
-        = ph->m_client->m_migrate_start_rpc.on(*ph)(*fileset, theSizes, theModes);
+    // the response is in the form <errorcode, userstatus, uuid, deduplicated files>
+    double t_start = tl::timer::wtime();
+    std::tuple<int32_t, int32_t, uuid, std::vector<uint32_t>> start_call_result
+        = ph->m_start_call.call<std::tuple<int32_t, int32_t, uuid, std::vector<uint32_t>>>(
+                ph->m_client->m_migrate_start_rpc, *ph, *fileset, theSizes, theModes, theHashes);
+    ph->m_client->m_stats.record_phase(REMI_PHASE_START, tl::timer::wtime() - t_start);
+    // put back the fileset's original members
+    fileset->m_root        = std::move(tmp_root);
+    fileset->m_files       = std::move(tmp_files);
+    fileset->m_directories = std::move(tmp_dirs);
+
     int ret = std::get<0>(start_call_result);
     if(ret != REMI_SUCCESS) {
         cleanup();
@@ -389,115 +1190,228 @@ int migrate_using_abtio(
             *status = std::get<1>(start_call_result);
         return ret;
     }
-    // put back the fileset's original members
-    fileset->m_root        = std::move(tmp_root);
-    fileset->m_files       = std::move(tmp_files);
-    fileset->m_directories = std::move(tmp_dirs);
 
     auto& operation_id = std::get<2>(start_call_result);
+    auto& progress = *fileset->m_progress;
+    progress.started(operation_id.to_string());
 
-    auto abtio = ph->m_client->m_abtio;
-
-    // send a series of migrate_write RPC, pipelined with abti-io pread calls
-    size_t max_chunk_size = fileset->m_xfer_size;
-
-    if(abtio == ABT_IO_INSTANCE_NULL) {
-
-        std::vector<char> buffer(max_chunk_size);
-        for(uint32_t i = 0; i < files.size(); i++) {
-            size_t remaining_size = theSizes[i];
-            int fd = openedFileDescriptors[i];
-            size_t current_offset = 0;
-            while(remaining_size != 0) {
-                size_t chunk_size = remaining_size < max_chunk_size ? remaining_size : max_chunk_size;
-                buffer.resize(chunk_size);
-                auto sizeRead = read(fd, &buffer[0], chunk_size);
-                ret = ph->m_client->m_migrate_write_rpc.on(*ph)(operation_id, i, current_offset, buffer);
-                current_offset += chunk_size;
-                remaining_size -= chunk_size;
-            }
+    // files the provider deduplicated are already complete
+    std::vector<char> deduplicated(files.size(), 0);
+    for(auto i : std::get<3>(start_call_result)) {
+        if(i >= files.size()) continue;
+        deduplicated[i] = 1;
+        progress.sent(theSizes[i]);
+        progress.acked(theSizes[i], 1);
+    }
+
+    // send a series of migrate_write RPC, pipelined with file reads
+    size_t max_chunk_size = fileset->m_xfer_size_set ?
+        fileset->m_xfer_size : ph->m_client->m_default_xfer_size;
+
+    // in zero-copy mode the chunks are not serialized into the RPC, instead
+    // the provider pulls them from our buffers straight into its files;
+    // in a striped migration, chunks go through the handles in turn
+    bool zero_copy = mode & REMI_USE_ZEROCOPY;
+    auto send_chunk = [&stripes, &operation_id, zero_copy](
+            size_t chunk_index, uint32_t file_index, size_t offset,
+            const std::vector<char>& buffer, const tl::bulk& bulk) {
+        auto target = stripes[chunk_index % stripes.size()];
+        if(zero_copy)
+            return target->m_client->m_migrate_bulk_write_rpc.on(*target).async(
+                    operation_id, file_index, offset, buffer.size(), bulk);
+        else
+            return target->m_client->m_migrate_write_rpc.on(*target).async(
+                    operation_id, file_index, offset, buffer);
+    };
+    auto expose_buffer = [ph, zero_copy](std::vector<char>& buffer) {
+        if(!zero_copy) return tl::bulk();
+        std::vector<std::pair<void*,std::size_t>> segment(1, {buffer.data(), buffer.size()});
+        return ph->m_client->m_engine->expose(segment, tl::bulk_mode::read_only);
+    };
+
+    // with REMI_XFER_SIZE_AUTO, the chunk size and pipeline depth are tuned
+    // as the migration progresses, starting from the values last found
+    // for this target; a striped migration keeps the pipeline depth
+    // of chunks in flight on each of its handles
+    size_t pipeline_depth = std::max<size_t>(ph->m_client->m_pipeline_depth, 1) * stripes.size();
+    std::optional<xfer_tuner> tuner;
+    if(max_chunk_size == REMI_XFER_SIZE_AUTO) {
+        xfer_tuning initial;
+        initial.m_pipeline_depth = pipeline_depth;
+        {
+            std::lock_guard<tl::mutex> guard(ph->m_client->m_tunings_mtx);
+            auto it = ph->m_client->m_tunings.find(ph->m_target);
+            if(it != ph->m_client->m_tunings.end())
+                initial = it->second;
         }
+        tuner.emplace(initial, tl::timer::wtime());
+        max_chunk_size = initial.m_xfer_size;
+        pipeline_depth = initial.m_pipeline_depth;
+    }
 
-    } else {
+    // ring of chunk slots: a slot's buffer is refilled only once the RPC
+    // that sent its previous content has completed, so up to
+    // pipeline_depth RPCs are in flight while the next chunk is read
+    // (a deque, so that growing the ring does not move in-flight slots)
+    struct chunk_slot {
+        std::vector<char>                 buffer;
+        tl::bulk                          bulk;
+        std::optional<tl::async_response> response;
+        double                            sent_at = 0.0;
+        bool                              last_of_file = false;
+        uint32_t                          file = 0;
+        size_t                            offset = 0;
+    };
+    std::deque<chunk_slot> slots;
 
-        size_t current_chunk_offset  = 0; // offset of the chunk that ABT-IO has to read in this iteration
-        size_t previous_chunk_offset = 0; // offset of the chunk that should be send in this iteration
-        size_t current_chunk_size    = 0; // size of the chunk that ABT-IO has to read in this iteration
-        size_t previous_chunk_size = 0; // size of the chunk that should be send in this iteration
-        std::vector<char> current_buffer(max_chunk_size);  // buffer for ABT-IO to place data
-        std::vector<char> previous_buffer(max_chunk_size); // buffer to be sent
-
-        for(uint32_t i = 0; i < files.size(); i++) {
-            // reset variables
-            current_chunk_offset  = 0;
-            previous_chunk_offset = 0;
-            current_chunk_size    = 0;
-            previous_chunk_size   = 0;
-
-            size_t remaining_size = theSizes[i];
-            int fd = openedFileDescriptors[i];
-            // read first chunk
-            current_chunk_size = remaining_size < max_chunk_size ? remaining_size : max_chunk_size;
-            current_buffer.resize(current_chunk_size);
-            auto sizeRead = abt_io_pread(abtio, fd, &current_buffer[0], current_chunk_size, current_chunk_offset);
-            // swap variables
-            previous_chunk_offset = current_chunk_offset;
-            previous_chunk_size = current_chunk_size;
-            std::swap(current_buffer, previous_buffer);
-            current_chunk_offset += current_chunk_size;
-            remaining_size -= current_chunk_size;
-
-            // read remaining chunks and send in parallel
-            bool can_stop = false;
-            while(!can_stop) {
-                // issue RPC for the previous chunk
-                auto async_req = ph->m_client->m_migrate_write_rpc.on(*ph).async(operation_id, i, previous_chunk_offset, previous_buffer);
-                // read the current chunk
-                if(remaining_size == 0) {
-                    can_stop = true;
-                } else {
-                    current_chunk_size = remaining_size < max_chunk_size ? remaining_size : max_chunk_size;
-                    current_buffer.resize(current_chunk_size);
-                    auto sizeRead = abt_io_pread(abtio, fd, &current_buffer[0], current_chunk_size, current_chunk_offset);
-                }
-                // wait for the RPC to finish
-                ret = async_req.wait();
-                if(ret != REMI_SUCCESS)
-                    can_stop = true;
-                if(!can_stop) {
-                    previous_chunk_offset = current_chunk_offset;
-                    previous_chunk_size = current_chunk_size;
-                    current_chunk_offset += current_chunk_size;
-                    remaining_size -= current_chunk_size;
-                    std::swap(current_buffer, previous_buffer);
-                }
+    // (re)allocate the buffer of an idle slot, from the client's pool if possible
+    auto client = ph->m_client;
+    auto init_slot = [&io, &expose_buffer, client](chunk_slot& slot, size_t size) {
+        if(slot.buffer.capacity() != 0)
+            io->deregister_buffer(slot.buffer.data());
+        std::vector<char> buffer;
+        {
+            std::lock_guard<tl::mutex> guard(client->m_buffer_pool_mtx);
+            auto& pool = client->m_buffer_pool;
+            auto it = std::find_if(pool.begin(), pool.end(),
+                [size](const std::vector<char>& b) { return b.capacity() >= size; });
+            if(it != pool.end()) {
+                buffer = std::move(*it);
+                pool.erase(it);
             }
+        }
+        if(buffer.capacity() >= size)
+            buffer.resize(buffer.capacity());
+        else
+            buffer.resize(size);
+        buffer.swap(slot.buffer);
+        // buffers only shrink when resized, so their bulk handles remain valid
+        slot.bulk = expose_buffer(slot.buffer);
+        io->register_buffer(slot.buffer.data(), slot.buffer.size());
+    };
 
-            if(ret != REMI_SUCCESS) {
+    // wait for the RPC issued from a slot, if any; the chunk latency
+    // recorded is the time until the response was collected
+    auto& stats = ph->m_client->m_stats;
+    auto wait_slot = [&stats, &progress, &operation_id](chunk_slot& slot) {
+        int32_t r = REMI_SUCCESS;
+        if(slot.response) {
+            r = slot.response->wait();
+            slot.response.reset();
+            trace("chunk_rpc", 'e', operation_id, slot.file, slot.offset, slot.buffer.size());
+            stats.record_chunk(tl::timer::wtime() - slot.sent_at);
+            if(r == REMI_SUCCESS)
+                progress.acked(slot.buffer.size(), slot.last_of_file ? 1 : 0);
+        }
+        return r;
+    };
+
+    // chunks are pipelined across files, not only within a file; the
+    // migration pauses before each chunk while one of a higher priority
+    // is transferring
+    int32_t priority = fileset->m_priority;
+    client->m_priorities.add(priority);
+    double t_transfer = tl::timer::wtime();
+    size_t next_slot = 0;
+    for(uint32_t i = 0; i < files.size() && ret == REMI_SUCCESS; i++) {
+        if(deduplicated[i])
+            continue;
+        int fd = openedFileDescriptors[i];
+        size_t offset = 0;
+        while(offset < theSizes[i]) {
+            if(tuner) {
+                max_chunk_size = tuner->xfer_size();
+                pipeline_depth = tuner->pipeline_depth();
+            }
+            while(slots.size() < pipeline_depth)
+                slots.emplace_back();
+            auto& slot = slots[next_slot % pipeline_depth];
+            next_slot += 1;
+            double wait_start = tl::timer::wtime();
+            ret = wait_slot(slot);
+            double wait_time = tl::timer::wtime() - wait_start;
+            if(ret != REMI_SUCCESS)
+                break;
+            size_t chunk_size = std::min(theSizes[i] - offset, max_chunk_size);
+            if(slot.buffer.capacity() < chunk_size)
+                init_slot(slot, max_chunk_size);
+            slot.buffer.resize(chunk_size);
+            client->m_priorities.wait(priority);
+            client->m_throttle.acquire(*client->m_engine, chunk_size);
+            trace("read", 'b', operation_id, i, offset, chunk_size);
+            size_t read_size = read_chunk(*io, fd, slot.buffer.data(), chunk_size, offset);
+            trace("read", 'e', operation_id, i, offset, chunk_size);
+            if(read_size != chunk_size) {
+                stats.m_io_errors += 1;
+                ret = REMI_ERR_IO;
                 break;
             }
+            slot.sent_at = tl::timer::wtime();
+            slot.last_of_file = offset + chunk_size == theSizes[i];
+            slot.file   = i;
+            slot.offset = offset;
+            trace("chunk_rpc", 'b', operation_id, i, offset, chunk_size);
+            slot.response.emplace(send_chunk(next_slot, i, offset, slot.buffer, slot.bulk));
+            progress.sent(chunk_size);
+            offset += chunk_size;
+            if(tuner)
+                tuner->record(chunk_size, wait_time, tl::timer::wtime());
+        }
+    }
+
+    // drain the pipeline, keeping the first error
+    for(auto& slot : slots) {
+        int32_t r = wait_slot(slot);
+        if(ret == REMI_SUCCESS)
+            ret = r;
+        if(slot.buffer.capacity() != 0)
+            io->deregister_buffer(slot.buffer.data());
+    }
+    client->m_priorities.remove(priority);
+    stats.record_phase(REMI_PHASE_TRANSFER, tl::timer::wtime() - t_transfer);
+
+    // keep the buffers for the next migrations
+    {
+        std::lock_guard<tl::mutex> guard(client->m_buffer_pool_mtx);
+        for(auto& slot : slots) {
+            if(client->m_buffer_pool.size() >= client->m_buffer_pool_size)
+                break;
+            if(slot.buffer.capacity() != 0)
+                client->m_buffer_pool.push_back(std::move(slot.buffer));
         }
+    }
 
+    if(tuner && ret == REMI_SUCCESS) {
+        std::lock_guard<tl::mutex> guard(ph->m_client->m_tunings_mtx);
+        ph->m_client->m_tunings[ph->m_target] = tuner->best();
     }
 
     if(ret != REMI_SUCCESS) {
+        abort_migration(ph, operation_id);
         cleanup();
         return ret;
     }
 
     // xfer went ok, now send migrate_end rpc.
-    // the response is in the form <errorcode, userstatus>
-    std::pair<int32_t, int32_t> end_call_result =
-        ph->m_client->m_migrate_end_rpc.on(*ph)(operation_id);
+    // the response is in the form <errorcode, userstatus, durability>
+    double t_end = tl::timer::wtime();
+    std::tuple<int32_t, int32_t, int32_t> end_call_result =
+        ph->m_end_call.call<std::tuple<int32_t, int32_t, int32_t>>(
+                ph->m_client->m_migrate_end_rpc, *ph, operation_id);
+    ph->m_client->m_stats.record_phase(REMI_PHASE_END, tl::timer::wtime() - t_end);
 
     cleanup();
 
-    ret = end_call_result.first;
+    ret = std::get<0>(end_call_result);
     if(ret == REMI_ERR_USER) {
-        *status = end_call_result.second;
+        *status = std::get<1>(end_call_result);
     } else {
         *status = 0;
     }
+    fileset->m_progress->durable(std::get<2>(end_call_result));
+
+    if(ret == REMI_SUCCESS)
+        ph->m_client->m_stats.m_bytes_migrated += total_size(theSizes);
 
     return ret;
 }
@@ -0,0 +1,143 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __REMI_DEDUP_HPP
+#define __REMI_DEDUP_HPP
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+/**
+ * Persistent index from content hashes to files received by a provider.
+ * Entries are appended to a log file, one per line:
+ *     <hash> <size> <mtime in ns> <inode> <path>
+ * and the log is replayed when the index is opened, later lines
+ * overriding earlier ones, then rewritten with only the entries left.
+ * An entry is only trusted while the file it points to keeps the size,
+ * modification time and inode recorded with it; entries whose file
+ * changed are dropped when looked up or when the index is opened.
+ */
+class dedup_index {
+
+    struct entry {
+        std::string m_path;
+        uint64_t    m_size  = 0;
+        uint64_t    m_mtime = 0;
+        uint64_t    m_ino   = 0;
+    };
+
+    tl::mutex                              m_mutex;
+    std::ofstream                          m_log;
+    std::unordered_map<std::string, entry> m_entries;
+
+    static uint64_t mtime_of(const struct stat& st) {
+        return (uint64_t)st.st_mtim.tv_sec*1000000000 + st.st_mtim.tv_nsec;
+    }
+
+    /* whether the file of an entry is still the one that was indexed */
+    static bool is_current(const entry& e) {
+        struct stat st;
+        return stat(e.m_path.c_str(), &st) == 0
+            && (uint64_t)st.st_size == e.m_size
+            && mtime_of(st) == e.m_mtime
+            && (uint64_t)st.st_ino == e.m_ino;
+    }
+
+    static void write_entry(std::ostream& out, const std::string& hash, const entry& e) {
+        out << hash << ' ' << e.m_size << ' ' << e.m_mtime << ' '
+            << e.m_ino << ' ' << e.m_path << '\n';
+    }
+
+    /* must be called with m_mutex held; on failure the log is left as is */
+    void compact(const std::string& log_path) {
+        auto tmp_path = log_path + ".compact";
+        {
+            std::ofstream out(tmp_path, std::ios::trunc);
+            for(auto& p : m_entries)
+                write_entry(out, p.first, p.second);
+            out.flush();
+            if(out.good() && std::rename(tmp_path.c_str(), log_path.c_str()) == 0)
+                return;
+        }
+        unlink(tmp_path.c_str());
+    }
+
+    public:
+
+    bool m_allow_hardlinks = false; // link files when they cannot be reflinked
+
+    /* loads the index from its log, creating the log if needed, and
+       compacts the log so that it does not grow with every file that was
+       indexed again or changed since */
+    bool open(const std::string& log_path) {
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        m_entries.clear();
+        {
+            std::ifstream in(log_path);
+            std::string hash;
+            entry e;
+            while(in >> hash >> e.m_size >> e.m_mtime >> e.m_ino) {
+                in.get(); // separator
+                if(!std::getline(in, e.m_path)) break;
+                m_entries[hash] = e;
+            }
+        }
+        for(auto it = m_entries.begin(); it != m_entries.end(); ) {
+            if(is_current(it->second))
+                ++it;
+            else
+                it = m_entries.erase(it);
+        }
+        m_log.close();
+        compact(log_path);
+        m_log.open(log_path, std::ios::app);
+        return m_log.good();
+    }
+
+    bool is_open() {
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        return m_log.is_open();
+    }
+
+    /* finds a file of the given size whose content has the given hash */
+    bool lookup(const std::string& hash, uint64_t size, std::string* path) {
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        auto it = m_entries.find(hash);
+        if(it == m_entries.end())
+            return false;
+        if(!is_current(it->second)) {
+            m_entries.erase(it);
+            return false;
+        }
+        if(it->second.m_size != size)
+            return false;
+        *path = it->second.m_path;
+        return true;
+    }
+
+    /* records that the file at path has the given hash */
+    void add(const std::string& hash, const std::string& path) {
+        struct stat st;
+        if(stat(path.c_str(), &st) != 0)
+            return;
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        if(!m_log.is_open())
+            return;
+        entry e{path, (uint64_t)st.st_size, mtime_of(st), (uint64_t)st.st_ino};
+        write_entry(m_log, hash, e);
+        m_log.flush();
+        m_entries[hash] = std::move(e);
+    }
+};
+
+#endif
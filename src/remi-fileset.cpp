@@ -48,10 +48,10 @@ extern "C" int remi_fileset_set_xfer_size(
         remi_fileset_t fileset,
         size_t size)
 {
-    if(fileset == REMI_FILESET_NULL
-    || size == 0)
+    if(fileset == REMI_FILESET_NULL)
         return REMI_ERR_INVALID_ARG;
     fileset->m_xfer_size = size;
+    fileset->m_xfer_size_set = true;
     return REMI_SUCCESS;
 }
 
@@ -66,6 +66,71 @@ extern "C" int remi_fileset_get_xfer_size(
     return REMI_SUCCESS;
 }
 
+extern "C" int remi_fileset_set_priority(
+        remi_fileset_t fileset,
+        int32_t priority)
+{
+    if(fileset == REMI_FILESET_NULL)
+        return REMI_ERR_INVALID_ARG;
+    fileset->m_priority = priority;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_fileset_get_priority(
+        remi_fileset_t fileset,
+        int32_t* priority)
+{
+    if(fileset == REMI_FILESET_NULL
+    || priority == nullptr)
+        return REMI_ERR_INVALID_ARG;
+    *priority = fileset->m_priority;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_fileset_set_staging(
+        remi_fileset_t fileset,
+        int staging)
+{
+    if(fileset == REMI_FILESET_NULL)
+        return REMI_ERR_INVALID_ARG;
+    fileset->m_staging = staging != 0;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_fileset_get_staging(
+        remi_fileset_t fileset,
+        int* staging)
+{
+    if(fileset == REMI_FILESET_NULL
+    || staging == nullptr)
+        return REMI_ERR_INVALID_ARG;
+    *staging = fileset->m_staging;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_fileset_set_durability(
+        remi_fileset_t fileset,
+        int policy)
+{
+    if(fileset == REMI_FILESET_NULL
+    || policy < REMI_DURABILITY_DEFAULT
+    || policy > REMI_DURABILITY_WRITEBACK)
+        return REMI_ERR_INVALID_ARG;
+    fileset->m_durability = policy;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_fileset_get_durability(
+        remi_fileset_t fileset,
+        int* policy)
+{
+    if(fileset == REMI_FILESET_NULL
+    || policy == nullptr)
+        return REMI_ERR_INVALID_ARG;
+    *policy = fileset->m_durability;
+    return REMI_SUCCESS;
+}
+
 extern "C" int remi_fileset_get_class(
         remi_fileset_t fileset,
         char* buf,
@@ -9,10 +9,14 @@
 #include <string>
 #include <map>
 #include <set>
+#include <memory>
+#include "remi/remi-common.h"
 #include <thallium/serialization/stl/string.hpp>
 #include <thallium/serialization/stl/set.hpp>
 #include <thallium/serialization/stl/map.hpp>
 
+struct migration_progress;
+
 struct remi_fileset {
 
     std::string                       m_class;
@@ -22,6 +26,11 @@ struct remi_fileset {
     std::set<std::string>             m_files;
     std::set<std::string>             m_directories;
     size_t                            m_xfer_size = 1048576;
+    int32_t                           m_priority = REMI_PRIORITY_DEFAULT;
+    bool                              m_staging = false;
+    int32_t                           m_durability = REMI_DURABILITY_DEFAULT;
+    std::shared_ptr<migration_progress> m_progress; // client side only, not serialized
+    bool                              m_xfer_size_set = false; // not serialized
 
     template<typename A>
     void serialize(A& ar) {
@@ -32,6 +41,9 @@ struct remi_fileset {
         ar & m_files;
         ar & m_directories;
         ar & m_xfer_size;
+        ar & m_priority;
+        ar & m_staging;
+        ar & m_durability;
     }
 };
 
@@ -0,0 +1,264 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <errno.h>
+#include <sys/uio.h>
+#include <liburing.h>
+#include <vector>
+#include <unordered_map>
+#include "remi-io.hpp"
+
+namespace {
+
+/**
+ * io_uring backend. Calling ULTs prepare their request in the
+ * submission queue, submit it, and block on an eventual. A poller ULT,
+ * running on an execution stream of its own so that it can block in
+ * io_uring_wait_cqe without holding up other ULTs, sets the eventuals
+ * as completions arrive. Registered buffers and files are used in place
+ * of regular ones whenever possible.
+ */
+class io_uring_backend : public io_backend {
+
+    static constexpr unsigned s_max_fixed = 64;
+
+    struct io_request {
+        tl::eventual<ssize_t> m_result;
+    };
+
+    struct io_uring                      m_ring;
+    tl::mutex                            m_mutex;        // protects the submission queue
+    bool                                 m_running  = false;
+    bool                                 m_fixed_files   = false;
+    bool                                 m_fixed_buffers = false;
+    std::unordered_map<int, unsigned>    m_file_slots;   // fd -> slot
+    std::vector<bool>                    m_file_slot_used;
+    std::vector<std::pair<char*,size_t>> m_buffer_slots; // slot -> buffer
+    tl::managed<tl::pool>                m_poller_pool;
+    tl::managed<tl::xstream>             m_poller_xstream;
+    tl::managed<tl::thread>              m_poller;
+
+    /* reaps completions until the one without a request, which the
+       destructor submits, arrives */
+    void poll() {
+        std::vector<struct io_uring_cqe*> cqes(64);
+        bool stop = false;
+        while(!stop) {
+            struct io_uring_cqe* cqe;
+            int ret = io_uring_wait_cqe(&m_ring, &cqe);
+            if(ret == -EINTR || ret == -EAGAIN)
+                continue;
+            if(ret < 0)
+                break;
+            unsigned count = io_uring_peek_batch_cqe(&m_ring, cqes.data(), cqes.size());
+            for(unsigned i = 0; i < count; i++) {
+                auto req = static_cast<io_request*>(io_uring_cqe_get_data(cqes[i]));
+                if(req == nullptr)
+                    stop = true;
+                else
+                    req->m_result.set_value(cqes[i]->res);
+            }
+            io_uring_cq_advance(&m_ring, count);
+        }
+    }
+
+    /* must be called with m_mutex held */
+    struct io_uring_sqe* get_sqe(std::unique_lock<tl::mutex>& lock) {
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&m_ring);
+        while(sqe == nullptr) {
+            // submission queue full, let the kernel consume it
+            if(io_uring_submit(&m_ring) <= 0) {
+                lock.unlock();
+                tl::thread::yield();
+                lock.lock();
+            }
+            sqe = io_uring_get_sqe(&m_ring);
+        }
+        return sqe;
+    }
+
+    template<typename F>
+    ssize_t submit(F&& prepare) {
+        io_request req;
+        {
+            std::unique_lock<tl::mutex> lock(m_mutex);
+            struct io_uring_sqe* sqe = get_sqe(lock);
+            prepare(sqe);
+            io_uring_sqe_set_data(sqe, &req);
+            io_uring_submit(&m_ring);
+        }
+        ssize_t res = req.m_result.wait();
+        if(res < 0) {
+            errno = -res;
+            return -1;
+        }
+        return res;
+    }
+
+    /* must be called with m_mutex held */
+    int file_for(int fd) {
+        auto it = m_file_slots.find(fd);
+        if(it == m_file_slots.end())
+            return -1;
+        return it->second;
+    }
+
+    /* must be called with m_mutex held */
+    int buffer_for(const void* buf, size_t count) {
+        auto p = static_cast<const char*>(buf);
+        for(unsigned i = 0; i < m_buffer_slots.size(); i++) {
+            auto& slot = m_buffer_slots[i];
+            if(slot.first != nullptr && p >= slot.first
+            && p + count <= slot.first + slot.second)
+                return i;
+        }
+        return -1;
+    }
+
+    public:
+
+    io_uring_backend(unsigned queue_depth, bool* ok) {
+        *ok = false;
+        if(io_uring_queue_init(queue_depth, &m_ring, 0) < 0)
+            return;
+        m_fixed_files   = io_uring_register_files_sparse(&m_ring, s_max_fixed) == 0;
+        m_fixed_buffers = io_uring_register_buffers_sparse(&m_ring, s_max_fixed) == 0;
+        if(m_fixed_files)
+            m_file_slot_used.resize(s_max_fixed, false);
+        if(m_fixed_buffers)
+            m_buffer_slots.resize(s_max_fixed, {nullptr, 0});
+        m_poller_pool    = tl::pool::create(tl::pool::access::mpmc, tl::pool::kind::fifo_wait);
+        m_poller_xstream = tl::xstream::create(tl::scheduler::predef::basic_wait, *m_poller_pool);
+        m_poller = m_poller_pool->make_thread([this]() { poll(); });
+        m_running = true;
+        *ok = true;
+    }
+
+    ~io_uring_backend() {
+        if(!m_running) return;
+        {
+            // a request without data tells the poller to stop
+            std::unique_lock<tl::mutex> lock(m_mutex);
+            struct io_uring_sqe* sqe = get_sqe(lock);
+            io_uring_prep_nop(sqe);
+            io_uring_sqe_set_data(sqe, nullptr);
+            io_uring_submit(&m_ring);
+        }
+        m_poller->join();
+        m_poller_xstream->join();
+        io_uring_queue_exit(&m_ring);
+    }
+
+    ssize_t pread(int fd, void* buf, size_t count, off_t offset) override {
+        return submit([&](struct io_uring_sqe* sqe) {
+            int buf_index = buffer_for(buf, count);
+            int slot = file_for(fd);
+            int file = slot >= 0 ? slot : fd;
+            if(buf_index >= 0)
+                io_uring_prep_read_fixed(sqe, file, buf, count, offset, buf_index);
+            else
+                io_uring_prep_read(sqe, file, buf, count, offset);
+            // the prep functions reset the flags, so this comes last
+            if(slot >= 0)
+                sqe->flags |= IOSQE_FIXED_FILE;
+        });
+    }
+
+    ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset) override {
+        return submit([&](struct io_uring_sqe* sqe) {
+            int buf_index = buffer_for(buf, count);
+            int slot = file_for(fd);
+            int file = slot >= 0 ? slot : fd;
+            if(buf_index >= 0)
+                io_uring_prep_write_fixed(sqe, file, buf, count, offset, buf_index);
+            else
+                io_uring_prep_write(sqe, file, buf, count, offset);
+            // the prep functions reset the flags, so this comes last
+            if(slot >= 0)
+                sqe->flags |= IOSQE_FIXED_FILE;
+        });
+    }
+
+    int fdatasync(int fd) override {
+        ssize_t ret = submit([&](struct io_uring_sqe* sqe) {
+            int slot = file_for(fd);
+            io_uring_prep_fsync(sqe, slot >= 0 ? slot : fd, IORING_FSYNC_DATASYNC);
+            if(slot >= 0)
+                sqe->flags |= IOSQE_FIXED_FILE;
+        });
+        return ret < 0 ? -1 : 0;
+    }
+
+    int fallocate(int fd, off_t offset, off_t len) override {
+        ssize_t ret = submit([&](struct io_uring_sqe* sqe) {
+            int slot = file_for(fd);
+            io_uring_prep_fallocate(sqe, slot >= 0 ? slot : fd, 0, offset, len);
+            if(slot >= 0)
+                sqe->flags |= IOSQE_FIXED_FILE;
+        });
+        return ret < 0 ? -1 : 0;
+    }
+
+    bool yields() const override {
+        return true;
+    }
+
+    void register_buffer(void* buf, size_t size) override {
+        std::lock_guard<tl::mutex> lock(m_mutex);
+        for(unsigned i = 0; i < m_buffer_slots.size(); i++) {
+            if(m_buffer_slots[i].first != nullptr) continue;
+            struct iovec iov = { buf, size };
+            __u64 tag = 0;
+            if(io_uring_register_buffers_update_tag(&m_ring, i, &iov, &tag, 1) == 1)
+                m_buffer_slots[i] = { static_cast<char*>(buf), size };
+            return;
+        }
+    }
+
+    void deregister_buffer(void* buf) override {
+        std::lock_guard<tl::mutex> lock(m_mutex);
+        for(unsigned i = 0; i < m_buffer_slots.size(); i++) {
+            if(m_buffer_slots[i].first != buf) continue;
+            struct iovec iov = { nullptr, 0 };
+            __u64 tag = 0;
+            io_uring_register_buffers_update_tag(&m_ring, i, &iov, &tag, 1);
+            m_buffer_slots[i] = { nullptr, 0 };
+            return;
+        }
+    }
+
+    void register_file(int fd) override {
+        std::lock_guard<tl::mutex> lock(m_mutex);
+        if(m_file_slots.count(fd)) return;
+        for(unsigned i = 0; i < m_file_slot_used.size(); i++) {
+            if(m_file_slot_used[i]) continue;
+            if(io_uring_register_files_update(&m_ring, i, &fd, 1) == 1) {
+                m_file_slot_used[i] = true;
+                m_file_slots[fd] = i;
+            }
+            return;
+        }
+    }
+
+    void deregister_file(int fd) override {
+        std::lock_guard<tl::mutex> lock(m_mutex);
+        auto it = m_file_slots.find(fd);
+        if(it == m_file_slots.end()) return;
+        int none = -1;
+        io_uring_register_files_update(&m_ring, it->second, &none, 1);
+        m_file_slot_used[it->second] = false;
+        m_file_slots.erase(it);
+    }
+};
+
+}
+
+std::unique_ptr<io_backend> make_io_uring_backend(unsigned queue_depth)
+{
+    bool ok;
+    auto backend = std::make_unique<io_uring_backend>(queue_depth, &ok);
+    if(!ok) return nullptr;
+    return backend;
+}
@@ -0,0 +1,297 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __REMI_IO_HPP
+#define __REMI_IO_HPP
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <abt-io.h>
+#include <thallium.hpp>
+#include "remi/remi-common.h"
+#include "sha256.hpp"
+
+namespace tl = thallium;
+
+/**
+ * Interface through which the client and the provider issue
+ * their file I/O. Buffers and file descriptors may be registered
+ * with the backend while they are in use, which lets backends
+ * that support it (io_uring) avoid mapping them on every call.
+ */
+class io_backend {
+
+    public:
+
+    virtual ~io_backend() = default;
+
+    virtual ssize_t pread(int fd, void* buf, size_t count, off_t offset) = 0;
+
+    virtual ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset) = 0;
+
+    virtual int fdatasync(int fd) = 0;
+
+    /* allocates blocks for [offset, offset+len), extending the file if needed */
+    virtual int fallocate(int fd, off_t offset, off_t len) = 0;
+
+    /* whether an I/O call lets other ULTs run while it is in flight */
+    virtual bool yields() const = 0;
+
+    virtual void register_buffer(void* buf, size_t size) { (void)buf; (void)size; }
+
+    virtual void deregister_buffer(void* buf) { (void)buf; }
+
+    virtual void register_file(int fd) { (void)fd; }
+
+    virtual void deregister_file(int fd) { (void)fd; }
+};
+
+/**
+ * Plain blocking system calls, issued from the calling ULT.
+ */
+class posix_io_backend : public io_backend {
+
+    public:
+
+    ssize_t pread(int fd, void* buf, size_t count, off_t offset) override {
+        return ::pread(fd, buf, count, offset);
+    }
+
+    ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset) override {
+        return ::pwrite(fd, buf, count, offset);
+    }
+
+    int fdatasync(int fd) override {
+        return ::fdatasync(fd);
+    }
+
+    int fallocate(int fd, off_t offset, off_t len) override {
+        return ::fallocate(fd, 0, offset, len);
+    }
+
+    bool yields() const override {
+        return false;
+    }
+};
+
+/**
+ * Blocking system calls issued from a dedicated execution stream
+ * owned by the backend, or from a pool provided by the user, so the
+ * calling ULT yields while they run.
+ */
+class xstream_io_backend : public io_backend {
+
+    tl::managed<tl::pool>    m_own_pool;
+    tl::managed<tl::xstream> m_xstream;
+    tl::pool                 m_pool;
+    bool                     m_owns_xstream = false;
+
+    template<typename F>
+    ssize_t run(F&& syscall) {
+        tl::eventual<std::pair<ssize_t,int>> result;
+        m_pool.make_thread([&syscall, &result]() {
+            ssize_t r = syscall();
+            result.set_value(std::make_pair(r, errno));
+        }, tl::anonymous());
+        auto r = result.wait();
+        if(r.first < 0) errno = r.second;
+        return r.first;
+    }
+
+    public:
+
+    xstream_io_backend() {
+        m_own_pool = tl::pool::create(tl::pool::access::mpmc, tl::pool::kind::fifo_wait);
+        m_xstream  = tl::xstream::create(tl::scheduler::predef::basic_wait, *m_own_pool);
+        m_pool     = *m_own_pool;
+        m_owns_xstream = true;
+    }
+
+    xstream_io_backend(const tl::pool& pool)
+    : m_pool(pool) {}
+
+    ~xstream_io_backend() {
+        if(m_owns_xstream)
+            m_xstream->join();
+    }
+
+    ssize_t pread(int fd, void* buf, size_t count, off_t offset) override {
+        return run([=]() { return ::pread(fd, buf, count, offset); });
+    }
+
+    ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset) override {
+        return run([=]() { return ::pwrite(fd, buf, count, offset); });
+    }
+
+    int fdatasync(int fd) override {
+        return run([=]() { return (ssize_t)::fdatasync(fd); });
+    }
+
+    int fallocate(int fd, off_t offset, off_t len) override {
+        return run([=]() { return (ssize_t)::fallocate(fd, 0, offset, len); });
+    }
+
+    bool yields() const override {
+        return true;
+    }
+};
+
+/**
+ * System calls forwarded to the execution streams of an ABT-IO instance.
+ */
+class abtio_io_backend : public io_backend {
+
+    abt_io_instance_id m_abtio;
+
+    public:
+
+    abtio_io_backend(abt_io_instance_id abtio)
+    : m_abtio(abtio) {}
+
+    ssize_t pread(int fd, void* buf, size_t count, off_t offset) override {
+        ssize_t ret = abt_io_pread(m_abtio, fd, buf, count, offset);
+        if(ret < 0) {
+            errno = -ret;
+            return -1;
+        }
+        return ret;
+    }
+
+    ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset) override {
+        ssize_t ret = abt_io_pwrite(m_abtio, fd, buf, count, offset);
+        if(ret < 0) {
+            errno = -ret;
+            return -1;
+        }
+        return ret;
+    }
+
+    int fdatasync(int fd) override {
+        int ret = abt_io_fdatasync(m_abtio, fd);
+        if(ret < 0) {
+            errno = -ret;
+            return -1;
+        }
+        return 0;
+    }
+
+    int fallocate(int fd, off_t offset, off_t len) override {
+        int ret = abt_io_fallocate(m_abtio, fd, 0, offset, len);
+        if(ret < 0) {
+            errno = -ret;
+            return -1;
+        }
+        return 0;
+    }
+
+    bool yields() const override {
+        return true;
+    }
+};
+
+#ifdef REMI_HAS_IO_URING
+/**
+ * Creates an io_uring backend whose completions are reaped by
+ * a ULT running on an execution stream of its own.
+ */
+std::unique_ptr<io_backend> make_io_uring_backend(unsigned queue_depth);
+#endif
+
+/**
+ * Calls f(i) for i in [0, count) from up to max_ults ULTs created in pool,
+ * so that the I/O calls f issues overlap when the backend yields or when
+ * the pool is served by several execution streams. Returns once all the
+ * calls have completed.
+ */
+template<typename F>
+void parallel_io(tl::pool pool, size_t count, size_t max_ults, F&& f)
+{
+    size_t n = std::min(count, max_ults);
+    std::vector<tl::managed<tl::thread>> ults;
+    for(size_t u = 0; u < n; u++) {
+        ults.push_back(pool.make_thread([u, n, count, &f]() {
+            for(size_t i = u; i < count; i += n)
+                f(i);
+        }));
+    }
+    for(auto& ult : ults)
+        ult->join();
+}
+
+/**
+ * Reads size bytes at the given offset, retrying on short reads.
+ * Returns the number of bytes read, which is less than size only
+ * if an error occured or the end of the file was reached.
+ */
+inline size_t read_chunk(io_backend& io, int fd, char* buf, size_t size, size_t offset)
+{
+    size_t done = 0;
+    while(done < size) {
+        ssize_t r = io.pread(fd, buf + done, size - done, offset + done);
+        if(r < 0 && errno == EINTR)
+            continue;
+        if(r <= 0)
+            break;
+        done += r;
+    }
+    return done;
+}
+
+/**
+ * Computes the SHA-256 of the first size bytes of a file.
+ * Returns an empty string if the file could not be read.
+ */
+inline std::string hash_file(io_backend& io, int fd, size_t size)
+{
+    sha256 h;
+    std::vector<char> buffer(std::min<size_t>(size, 1048576));
+    for(size_t offset = 0; offset < size; ) {
+        size_t n = std::min(size - offset, buffer.size());
+        if(read_chunk(io, fd, buffer.data(), n, offset) != n)
+            return std::string();
+        h.update(buffer.data(), n);
+        offset += n;
+    }
+    return h.hex_digest();
+}
+
+/**
+ * Creates the backend corresponding to the requested REMI_IO_* type.
+ * REMI_IO_DEFAULT resolves to ABT-IO if an instance is provided, and
+ * to no_abtio_type otherwise. If io_pool is not null, the XSTREAM
+ * backend issues its calls from it instead of creating its own
+ * execution stream.
+ * Returns nullptr if the type is unknown or not supported by this build.
+ */
+inline std::unique_ptr<io_backend> make_io_backend(
+        int type, abt_io_instance_id abtio,
+        int no_abtio_type = REMI_IO_POSIX, const tl::pool& io_pool = tl::pool())
+{
+    if(type == REMI_IO_DEFAULT)
+        type = abtio == ABT_IO_INSTANCE_NULL ? no_abtio_type : REMI_IO_ABTIO;
+    switch(type) {
+    case REMI_IO_POSIX:
+        return std::make_unique<posix_io_backend>();
+    case REMI_IO_XSTREAM:
+        if(io_pool.native_handle() != ABT_POOL_NULL)
+            return std::make_unique<xstream_io_backend>(io_pool);
+        return std::make_unique<xstream_io_backend>();
+    case REMI_IO_ABTIO:
+        if(abtio == ABT_IO_INSTANCE_NULL) return nullptr;
+        return std::make_unique<abtio_io_backend>(abtio);
+#ifdef REMI_HAS_IO_URING
+    case REMI_IO_URING:
+        return make_io_uring_backend(256);
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __REMI_PROGRESS_HPP
+#define __REMI_PROGRESS_HPP
+
+#include <cstring>
+#include <string>
+#include <mutex>
+#include <thallium.hpp>
+#include "remi/remi-client.h"
+
+namespace tl = thallium;
+
+/**
+ * Progress of the migration of a fileset, updated by the ULT running
+ * remi_fileset_migrate and read by remi_fileset_get_progress.
+ */
+struct migration_progress {
+
+    mutable tl::mutex        m_mutex;
+    std::string              m_operation_id;
+    uint64_t                 m_bytes_total     = 0;
+    uint64_t                 m_bytes_sent      = 0;
+    uint64_t                 m_bytes_acked     = 0;
+    uint64_t                 m_files_total     = 0;
+    uint64_t                 m_files_completed = 0;
+    double                   m_start           = 0.0;
+    double                   m_end             = 0.0;
+    bool                     m_done            = false;
+    int                      m_durability      = REMI_DURABILITY_DEFAULT;
+    remi_progress_callback_t m_callback        = nullptr;
+    void*                    m_uargs           = nullptr;
+
+    static void fill(remi_progress_t* p, const std::string& operation_id,
+                     uint64_t bytes_total, uint64_t bytes_sent, uint64_t bytes_acked,
+                     uint64_t files_total, uint64_t files_completed, double elapsed) {
+        std::memset(p, 0, sizeof(*p));
+        std::strncpy(p->operation_id, operation_id.c_str(), sizeof(p->operation_id)-1);
+        p->bytes_total     = bytes_total;
+        p->bytes_sent      = bytes_sent;
+        p->bytes_acked     = bytes_acked;
+        p->files_total     = files_total;
+        p->files_completed = files_completed;
+        p->elapsed         = elapsed;
+        p->throughput      = elapsed > 0.0 ? bytes_acked / elapsed : 0.0;
+        if(bytes_acked == bytes_total)
+            p->eta = 0.0;
+        else if(p->throughput > 0.0)
+            p->eta = (bytes_total - bytes_acked) / p->throughput;
+        else
+            p->eta = -1.0;
+        p->durability      = REMI_DURABILITY_DEFAULT;
+    }
+
+    void snapshot(remi_progress_t* p) const {
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        double now = m_done ? m_end : tl::timer::wtime();
+        fill(p, m_operation_id, m_bytes_total, m_bytes_sent, m_bytes_acked,
+             m_files_total, m_files_completed, m_start == 0.0 ? 0.0 : now - m_start);
+        p->done = m_done;
+        p->durability = m_durability;
+    }
+
+    /* applies an update and notifies the callback, if any */
+    template<typename F>
+    void update(F&& f) {
+        {
+            std::lock_guard<tl::mutex> guard(m_mutex);
+            f();
+        }
+        if(m_callback) {
+            remi_progress_t p;
+            snapshot(&p);
+            m_callback(&p, m_uargs);
+        }
+    }
+
+    void begin(uint64_t files_total, uint64_t files_empty, uint64_t bytes_total) {
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        m_operation_id.clear();
+        m_bytes_total     = bytes_total;
+        m_bytes_sent      = 0;
+        m_bytes_acked     = 0;
+        m_files_total     = files_total;
+        m_files_completed = files_empty;
+        m_start           = tl::timer::wtime();
+        m_done            = false;
+        m_durability      = REMI_DURABILITY_DEFAULT;
+    }
+
+    void started(const std::string& operation_id) {
+        update([&]() { m_operation_id = operation_id; });
+    }
+
+    void sent(uint64_t bytes) {
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        m_bytes_sent += bytes;
+    }
+
+    void acked(uint64_t bytes, uint64_t files) {
+        update([&]() {
+            m_bytes_acked     += bytes;
+            m_files_completed += files;
+        });
+    }
+
+    /* records the durability policy the target applied */
+    void durable(int policy) {
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        m_durability = policy;
+    }
+
+    void finished(bool success) {
+        update([&]() {
+            if(success) {
+                m_bytes_sent      = m_bytes_total;
+                m_bytes_acked     = m_bytes_total;
+                m_files_completed = m_files_total;
+            }
+            m_end  = tl::timer::wtime();
+            m_done = true;
+        });
+    }
+};
+
+#endif
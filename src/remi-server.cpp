@@ -14,7 +14,12 @@
 #include <sys/mman.h>
 #include <string.h>
 #include <iostream>
+#include <algorithm>
+#include <deque>
 #include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include <abt-io.h>
 #include <thallium.hpp>
 #include <thallium/serialization/stl/pair.hpp>
@@ -25,6 +30,12 @@
 #include "remi-fileset.hpp"
 #include "fs-util.hpp"
 #include "uuid-util.hpp"
+#include "remi-io.hpp"
+#include "remi-stats.hpp"
+#include "remi-trace.hpp"
+#include "remi-throttle.hpp"
+#include "remi-dedup.hpp"
+#include "remi-space.hpp"
 
 namespace tl = thallium;
 
@@ -36,6 +47,7 @@ struct migration_class {
 };
 
 struct device {
+    std::string            m_mount_point;
     int                    m_type;
     tl::mutex              m_mutex;
 
@@ -52,13 +64,117 @@ struct device {
     }
 };
 
+/* devices declared with remi_set_device, shared by all the providers */
+static std::vector<std::unique_ptr<device>> s_devices;
+static std::mutex                           s_devices_mtx;
+
+/* finds the device with the longest mount point containing path */
+static device* find_device(const std::string& path)
+{
+    std::lock_guard<std::mutex> guard(s_devices_mtx);
+    device* found = nullptr;
+    for(auto& dev : s_devices) {
+        auto& mp = dev->m_mount_point;
+        if(path.compare(0, mp.size(), mp) != 0)
+            continue;
+        if(path.size() > mp.size() && mp.back() != '/' && path[mp.size()] != '/')
+            continue;
+        if(found == nullptr || mp.size() > found->m_mount_point.size())
+            found = dev.get();
+    }
+    return found;
+}
+
+/* holds a device's lock, if any, for the duration of a write */
+struct device_lock {
+    device* m_device;
+    device_lock(device* dev) : m_device(dev) { if(m_device) m_device->lock(); }
+    ~device_lock() { if(m_device) m_device->unlock(); }
+};
+
+/* the ledger is created on first use, once Argobots is initialized */
+static space_ledger& shared_space_ledger()
+{
+    static space_ledger s_space_ledger;
+    return s_space_ledger;
+}
+
+/* status of a pwrite that did not write everything: a short write does
+   not set errno, so only a failed call is looked at for lack of space */
+static int32_t write_error(ssize_t written)
+{
+    if(written >= 0)
+        return REMI_ERR_IO;
+    return (errno == ENOSPC || errno == EDQUOT) ? REMI_ERR_NO_SPACE : REMI_ERR_IO;
+}
+
 struct operation {
     remi_fileset             m_fileset;
     std::vector<std::size_t> m_filesizes;
     std::vector<mode_t>      m_modes;
     std::vector<int>         m_fds;
+    std::vector<bool>        m_truncated;
+    device*                  m_device = nullptr;
+    std::string              m_staging_dir;         // empty unless the fileset is staged
+    dev_t                    m_space_dev = 0;       // file system the space was reserved on
+    uint64_t                 m_space_reserved = 0;  // reserved bytes not allocated yet
+    std::vector<char>        m_preallocated;        // per file, whether fallocate succeeded
+    std::vector<std::string> m_hashes;              // per file content hash, if deduplicating
+    std::vector<char>        m_deduped;             // per file, whether it was filled from the index
     tl::mutex                m_mutex;
     int                      m_error = REMI_SUCCESS;
+    double                   m_transfer_start = 0.0;
+    int32_t                  m_durability = REMI_DURABILITY_NONE;
+    std::vector<std::size_t> m_received;            // bytes written, per file
+    uint64_t                 m_bytes_received  = 0;
+    uint64_t                 m_files_completed = 0;
+    double                   m_last_use = 0.0;      // guarded by the provider's map of operations
+    std::shared_ptr<io_backend> m_io;               // backend current when the operation started
+
+    /* an operation that did not end normally still holds its files
+       and part of its reservation */
+    ~operation() {
+        for(int fd : m_fds) {
+            if(fd != -1) close(fd);
+        }
+        if(m_space_reserved != 0)
+            shared_space_ledger().release(m_space_dev, m_space_reserved);
+    }
+
+    /* where a file of the fileset is written until the migration ends */
+    std::string write_path(const std::string& filename) const {
+        return (m_staging_dir.empty() ? m_fileset.m_root : m_staging_dir) + filename;
+    }
+
+    /* must be called with m_mutex held */
+    void record_received(uint32_t fileNumber, size_t size) {
+        // data written into a file that was not preallocated consumes its reservation
+        if(m_space_reserved != 0 && !m_preallocated[fileNumber]) {
+            uint64_t n = std::min<uint64_t>(size, m_space_reserved);
+            shared_space_ledger().release(m_space_dev, n);
+            m_space_reserved -= n;
+        }
+        m_received[fileNumber] += size;
+        m_bytes_received += size;
+        if(size != 0 && m_received[fileNumber] == m_filesizes[fileNumber])
+            m_files_completed += 1;
+    }
+};
+
+/* files a provider opened for another provider pulling them; they are
+   read a piece at a time as the destination asks for them, rather than
+   mapped, so that one truncated while it is being pulled cannot fault
+   the provider */
+struct fetch_source {
+    std::vector<int>         m_fds;    // -1 for empty files
+    std::vector<std::size_t> m_sizes;
+    double                   m_expires = 0.0;
+
+    ~fetch_source() {
+        for(int fd : m_fds) {
+            if(fd != -1) close(fd);
+        }
+    }
 };
 
 struct class_key {
@@ -80,146 +196,878 @@ struct remi_provider : public tl::provider<remi_provider> {
 
     tl::engine                                                      m_engine;
     std::unordered_map<class_key, migration_class, class_key_hash>  m_migration_classes;
-    tl::pool&                                                       m_pool;
+    tl::pool                                                        m_pool;      // control RPCs
+    tl::pool                                                        m_data_pool; // data RPCs
+    tl::pool                                                        m_io_pool;   // background I/O
     abt_io_instance_id                                              m_abtio;
-    std::unordered_map<uuid, std::unique_ptr<operation>, uuid_hash> m_op_in_progress;
+    int                                                             m_io_type = REMI_IO_DEFAULT;
+    int32_t                                                         m_durability = REMI_DURABILITY_FDATASYNC;
+    std::shared_ptr<io_backend>                                     m_io;        // see current_io()
+    std::unordered_map<uuid, std::shared_ptr<operation>, uuid_hash> m_op_in_progress;
     tl::mutex                                                       m_op_in_progress_mtx;
+    double                                                          m_op_timeout = 600.0; // seconds, 0 for none
+    stats_counters                                                  m_stats;
+    throttle                                                        m_throttle;
+    admission_gate                                                  m_admission;
+    priority_gate                                                   m_priorities;
+    dedup_index                                                     m_dedup;
+    std::vector<std::string>                                        m_source_roots; // canonical, with a trailing '/'
+    std::unordered_map<uuid, std::shared_ptr<fetch_source>, uuid_hash> m_fetches; // filesets being pulled from us
+    tl::mutex                                                       m_fetches_mtx;
+    tl::pool                                                        m_callback_pool; // asynchronous "after" callbacks
+    std::unordered_map<uuid, std::pair<bool,int32_t>, uuid_hash>    m_callbacks; // <done, status> per operation
+    std::deque<uuid>                                                m_callbacks_done; // in order of completion
+    size_t                                                          m_callbacks_running = 0;
+    std::unordered_map<class_key, size_t, class_key_hash>           m_class_callbacks_running;
+    tl::mutex                                                       m_callbacks_mtx;
+    tl::condition_variable                                          m_callbacks_cv;
     tl::auto_remote_procedure                                       m_migration_start_rpc;
     tl::auto_remote_procedure                                       m_migration_mmap_rpc;
     tl::auto_remote_procedure                                       m_migration_write_rpc;
+    tl::auto_remote_procedure                                       m_migration_bulk_write_rpc;
     tl::auto_remote_procedure                                       m_migration_end_rpc;
+    tl::auto_remote_procedure                                       m_migration_abort_rpc;
+    tl::auto_remote_procedure                                       m_migration_local_rpc;
+    tl::auto_remote_procedure                                       m_migration_status_rpc;
+    tl::auto_remote_procedure                                       m_pull_rpc;
+    tl::auto_remote_procedure                                       m_migration_batch_rpc;
+    tl::auto_remote_procedure                                       m_callback_status_rpc;
+    tl::auto_remote_procedure                                       m_fetch_open_rpc;
+    tl::auto_remote_procedure                                       m_fetch_read_rpc;
+    tl::auto_remote_procedure                                       m_fetch_close_rpc;
+    tl::remote_procedure                                            m_fetch_open_call;  // to source providers
+    tl::remote_procedure                                            m_fetch_read_call;
+    tl::remote_procedure                                            m_fetch_close_call;
 
     static std::unordered_map<uint16_t, remi_provider*> s_registered_providers;
 
-    void migrate_start(
-            const tl::request& req,
+    /* guards s_registered_providers; created on first use since an
+       Argobots mutex cannot be constructed before Argobots is initialized */
+    static tl::mutex& registered_providers_mutex() {
+        static tl::mutex s_mutex;
+        return s_mutex;
+    }
+
+    /* the I/O backend may be replaced while migrations are in progress,
+       so each operation or request keeps the one current when it started */
+    std::shared_ptr<io_backend> current_io() const
+    {
+        return std::atomic_load(&m_io);
+    }
+
+    void set_io(std::unique_ptr<io_backend> io)
+    {
+        std::atomic_store(&m_io, std::shared_ptr<io_backend>(std::move(io)));
+    }
+
+    /* the operation is shared with the requests working on it, so that
+       it outlives its removal from the map until they are done */
+    std::shared_ptr<operation> find_operation(const uuid& operation_id)
+    {
+        std::lock_guard<tl::mutex> guard(m_op_in_progress_mtx);
+        auto it = m_op_in_progress.find(operation_id);
+        if(it == m_op_in_progress.end())
+            return nullptr;
+        it->second->m_last_use = tl::timer::wtime();
+        return it->second;
+    }
+
+    /* removes an operation from the map and returns it, or returns null
+       if it was already gone; its files are closed and what is left of its
+       reserved space is released once the last request using it is done */
+    std::shared_ptr<operation> erase_operation(const uuid& operation_id)
+    {
+        std::shared_ptr<operation> op;
+        {
+            std::lock_guard<tl::mutex> guard(m_op_in_progress_mtx);
+            auto it = m_op_in_progress.find(operation_id);
+            if(it == m_op_in_progress.end())
+                return nullptr;
+            op = std::move(it->second);
+            m_op_in_progress.erase(it);
+            m_stats.m_active_operations -= 1;
+            m_admission.leave();
+        }
+        m_priorities.remove(op->m_fileset.m_priority);
+        // whatever is left in the staging directory (empty directories if the
+        // files were moved into place) is removed with it
+        if(!op->m_staging_dir.empty())
+            removeRec(op->m_staging_dir);
+        return op;
+    }
+
+    /* finds an operation started on this provider or, since the chunks of a
+       striped migration may arrive through any provider of this process,
+       on another one; owner is set to the provider holding the operation */
+    std::shared_ptr<operation> find_striped_operation(const uuid& operation_id,
+                                                      remi_provider** owner = nullptr)
+    {
+        if(owner) *owner = this;
+        auto op = find_operation(operation_id);
+        if(op != nullptr)
+            return op;
+        std::lock_guard<tl::mutex> guard(registered_providers_mutex());
+        for(auto& p : s_registered_providers) {
+            if(p.second == this) continue;
+            op = p.second->find_operation(operation_id);
+            if(op != nullptr) {
+                if(owner) *owner = p.second;
+                return op;
+            }
+        }
+        return nullptr;
+    }
+
+    /* drops an operation that failed, or that its client gave up on,
+       before it could be ended; returns false if it was already gone */
+    bool abort_operation(const uuid& operation_id)
+    {
+        auto op = erase_operation(operation_id);
+        if(!op)
+            return false;
+        m_stats.m_failed_migrations += 1;
+        // the files created in place are incomplete, the staged ones went
+        // away with the staging directory
+        if(op->m_staging_dir.empty()) {
+            for(const auto& filename : op->m_fileset.m_files)
+                unlink((op->m_fileset.m_root + filename).c_str());
+        }
+        return true;
+    }
+
+    /* aborts the operations that no request has used for m_op_timeout
+       seconds, i.e. whose client went away without ending them; those
+       a request is working on are left alone */
+    void expire_operations()
+    {
+        if(m_op_timeout <= 0.0)
+            return;
+        std::vector<uuid> expired;
+        {
+            std::lock_guard<tl::mutex> guard(m_op_in_progress_mtx);
+            double now = tl::timer::wtime();
+            for(auto& p : m_op_in_progress) {
+                if(p.second.use_count() == 1 && now - p.second->m_last_use > m_op_timeout)
+                    expired.push_back(p.first);
+            }
+        }
+        for(auto& operation_id : expired) {
+            if(abort_operation(operation_id))
+                std::cerr << "remi-server.cpp: operation " << operation_id.to_string()
+                    << " expired" << std::endl;
+        }
+    }
+
+    int32_t start_operation(
+            const uuid& operation_id,
             remi_fileset& fileset,
             std::vector<std::size_t>& filesizes,
-            std::vector<mode_t>& theModes)
+            std::vector<mode_t>& theModes,
+            const std::vector<std::string>& hashes,
+            int32_t* status,
+            std::vector<uint32_t>* deduplicated,
+            const std::vector<char>& in_place = std::vector<char>())
     {
-        // tuple of <returnvalue, userstatus, uuid>
-        std::tuple<int32_t,int32_t,uuid> result;
-        std::get<0>(result) = 0;
-        std::get<1>(result) = 1;
-        // uuid is initialized at random, which is what we want
+        // wait for a slot if too many operations are in progress, releasing
+        // the slots of abandoned operations in the meantime
+        static constexpr double s_expiry_period = 10.0;
+        expire_operations();
+        m_admission.enter(s_expiry_period, [this]() { expire_operations(); });
+        double t_start = tl::timer::wtime();
+        int32_t ret = start_operation_impl(operation_id, fileset, filesizes, theModes,
+                                           hashes, status, deduplicated, in_place);
+        m_stats.record_phase(REMI_PHASE_START, tl::timer::wtime() - t_start);
+        if(ret != REMI_SUCCESS) {
+            m_stats.m_failed_migrations += 1;
+            m_admission.leave();
+        }
+        return ret;
+    }
+
+    int32_t start_operation_impl(
+            const uuid& operation_id,
+            remi_fileset& fileset,
+            std::vector<std::size_t>& filesizes,
+            std::vector<mode_t>& theModes,
+            const std::vector<std::string>& hashes,
+            int32_t* status,
+            std::vector<uint32_t>* deduplicated,
+            const std::vector<char>& in_place)
+    {
+        *status = 0;
 
         // check that the class of the fileset exists
         auto key = class_key{fileset.m_class, fileset.m_provider_id};
-        if(m_migration_classes.count(key) == 0) {
-            std::get<0>(result) = REMI_ERR_UNKNOWN_CLASS;
-            req.respond(result);
-            return;
-        }
+        if(m_migration_classes.count(key) == 0)
+            return REMI_ERR_UNKNOWN_CLASS;
 
         // check if any of the target files already exist
         // (we don't want to overwrite)
         for(const auto& filename : fileset.m_files) {
             auto theFilename = fileset.m_root + filename;
-            if(access(theFilename.c_str(), F_OK) != -1) {
-                std::get<0>(result) = REMI_ERR_FILE_EXISTS;
-                req.respond(result);
-                return;
-            }
+            if(access(theFilename.c_str(), F_OK) != -1)
+                return REMI_ERR_FILE_EXISTS;
         }
         // alright, none of the files already exist
 
         // call the "before migration" callback
         auto& klass = m_migration_classes[key];
         if(klass.m_before_callback != nullptr) {
-            std::get<1>(result) = klass.m_before_callback(&fileset, klass.m_uargs);
-        }
-        if(std::get<1>(result) != 0) {
-            std::get<0>(result) = REMI_ERR_USER;
-            req.respond(result);
-            return;
+            trace("before_callback", 'b', operation_id);
+            *status = klass.m_before_callback(&fileset, klass.m_uargs);
+            trace("before_callback", 'e', operation_id);
         }
+        if(*status != 0)
+            return REMI_ERR_USER;
+
+        // create and open the files, in the staging directory if requested,
+        // record the device they belong to
+        std::string staging_dir;
+        if(fileset.m_staging)
+            staging_dir = fileset.m_root + ".remi-staging-" + operation_id.to_string() + "/";
+        // reserve the space the files need, rejecting the migration
+        // right away if they cannot fit; files that the caller will
+        // fill in place (by linking or cloning) take no new space
+        auto isInPlace = [&in_place](unsigned j) {
+            return j < in_place.size() && in_place[j];
+        };
+        uint64_t totalSize = 0;
+        for(unsigned j = 0; j < filesizes.size(); j++)
+            if(!isInPlace(j)) totalSize += filesizes[j];
+        dev_t space_dev;
+        int32_t ret = shared_space_ledger().reserve(fileset.m_root, totalSize, fileset.m_files.size(), &space_dev);
+        if(ret != REMI_SUCCESS)
+            return ret;
 
-        // create and open the files, record the device they belong to
         std::vector<int> openedFileDescriptors;
+        std::vector<std::string> createdFiles;
+        auto discard = [&]() {
+            shared_space_ledger().release(space_dev, totalSize);
+            for(auto ffd : openedFileDescriptors)
+                close(ffd);
+            for(auto& f : createdFiles)
+                unlink(f.c_str());
+            if(!staging_dir.empty())
+                removeRec(staging_dir);
+        };
         unsigned i=0;
         for(const auto& filename : fileset.m_files) {
-            auto theFilename = fileset.m_root + filename;
+            auto theFilename = (staging_dir.empty() ? fileset.m_root : staging_dir) + filename;
             auto p = theFilename.find_last_of('/');
             auto theDir = theFilename.substr(0, p);
             mkdirs(theDir.c_str());
             int fd = open(theFilename.c_str(), O_RDWR | O_CREAT | O_TRUNC, theModes[i]);
             if(fd == -1) {
-                for(auto ffd : openedFileDescriptors)
-                    close(ffd);
-                std::get<0>(result) = REMI_ERR_IO;
-                req.respond(result);
-                return;
+                m_stats.m_io_errors += 1;
+                discard();
+                return REMI_ERR_IO;
             }
             i += 1;
             openedFileDescriptors.push_back(fd);
+            createdFiles.push_back(std::move(theFilename));
         }
+
+        // give files whose content the provider already has that content,
+        // they will not be transferred
+        std::vector<char> deduped(openedFileDescriptors.size(), 0);
+        bool dedup = m_dedup.is_open() && hashes.size() == fileset.m_files.size();
+        if(dedup)
+            deduplicate(hashes, filesizes, theModes, openedFileDescriptors, createdFiles, deduped);
+
+        // allocate the files to their final size, so that they are not
+        // fragmented as chunks arrive and a lack of space shows up now
+        std::vector<char> preallocated(openedFileDescriptors.size(), 0);
+        std::vector<std::size_t> allocsizes(filesizes);
+        for(unsigned j = 0; j < deduped.size(); j++)
+            if(deduped[j] || isInPlace(j)) allocsizes[j] = 0;
+        auto io = current_io();
+        ret = preallocate(*io, openedFileDescriptors, allocsizes, preallocated);
+        if(ret != REMI_SUCCESS) {
+            if(ret == REMI_ERR_IO)
+                m_stats.m_io_errors += 1;
+            discard();
+            return ret;
+        }
+        // preallocated files no longer need their reservation
+        // and neither do deduplicated files, which take no new space
+        uint64_t allocated = 0;
+        for(unsigned j = 0; j < preallocated.size(); j++) {
+            if(isInPlace(j)) {
+                preallocated[j] = 1; // nothing reserved for it to consume
+                continue;
+            }
+            if(deduped[j]) preallocated[j] = 1;
+            if(preallocated[j]) allocated += filesizes[j];
+        }
+        shared_space_ledger().release(space_dev, allocated);
         // store the operation into the map of pending operations
         {
             std::lock_guard<tl::mutex> guard(m_op_in_progress_mtx);
-            auto r = m_op_in_progress.insert(std::make_pair(std::get<2>(result), std::make_unique<operation>()));
+            auto r = m_op_in_progress.insert(std::make_pair(operation_id, std::make_shared<operation>()));
             auto& op        = r.first->second;
             op->m_fileset   = std::move(fileset);
             op->m_filesizes = std::move(filesizes);
             op->m_modes     = std::move(theModes);
             op->m_fds       = std::move(openedFileDescriptors);
+            op->m_staging_dir = std::move(staging_dir);
+            op->m_space_dev      = space_dev;
+            op->m_space_reserved = totalSize - allocated;
+            op->m_preallocated   = std::move(preallocated);
+            op->m_io             = std::move(io);
+            if(dedup) {
+                op->m_hashes  = hashes;
+                op->m_deduped = deduped;
+            }
+            op->m_durability  = op->m_fileset.m_durability == REMI_DURABILITY_DEFAULT ?
+                m_durability : op->m_fileset.m_durability;
+            op->m_device    = find_device(op->m_fileset.m_root);
+            op->m_received.resize(op->m_filesizes.size(), 0);
+            op->m_files_completed = std::count(op->m_filesizes.begin(), op->m_filesizes.end(), 0);
+            for(uint32_t j = 0; j < deduped.size(); j++) {
+                if(!deduped[j]) continue;
+                op->record_received(j, op->m_filesizes[j]);
+                if(deduplicated) deduplicated->push_back(j);
+            }
+            op->m_transfer_start = tl::timer::wtime();
+            op->m_last_use       = op->m_transfer_start;
+            m_stats.m_active_operations += 1;
+            // lower-priority transfers pause until the operation ends
+            m_priorities.add(op->m_fileset.m_priority);
         }
+        return REMI_SUCCESS;
+    }
 
-        req.respond(result);
+    /* fills the files whose hash is in the dedup index from the file the
+       index points to, by cloning its extents or, if the file system cannot,
+       the index allows aliasing and the modes match, by replacing the new
+       file with a hard link; files that cannot be deduplicated are left
+       empty and get transferred */
+    void deduplicate(const std::vector<std::string>& hashes,
+                     const std::vector<std::size_t>& sizes,
+                     const std::vector<mode_t>& modes,
+                     std::vector<int>& fds,
+                     const std::vector<std::string>& paths,
+                     std::vector<char>& deduped)
+    {
+        for(unsigned i = 0; i < fds.size(); i++) {
+            std::string source;
+            if(hashes[i].empty() || sizes[i] == 0
+            || !m_dedup.lookup(hashes[i], sizes[i], &source))
+                continue;
+            int sfd = open(source.c_str(), O_RDONLY);
+            if(sfd == -1)
+                continue;
+            int r = -1;
+#ifdef FICLONE
+            r = ioctl(fds[i], FICLONE, sfd);
+#endif
+            // a link would give the new file the mode of the indexed one
+            struct stat st;
+            bool same_mode = fstat(sfd, &st) == 0
+                          && (st.st_mode & 07777) == (modes[i] & 07777);
+            close(sfd);
+            if(r == 0) {
+                deduped[i] = 1;
+            } else if(m_dedup.m_allow_hardlinks && same_mode) {
+                // the path now names the existing file, the descriptor is
+                // moved to it so that make_durable flushes the right inode
+                auto tmp = paths[i] + ".remi-dedup";
+                if(link(source.c_str(), tmp.c_str()) != 0)
+                    continue;
+                int lfd = open(tmp.c_str(), O_RDWR);
+                if(lfd == -1 || rename(tmp.c_str(), paths[i].c_str()) != 0) {
+                    if(lfd != -1) close(lfd);
+                    unlink(tmp.c_str());
+                    continue;
+                }
+                close(fds[i]);
+                fds[i] = lfd;
+                deduped[i] = 1;
+            }
+        }
     }
 
-    void migrate_end(const tl::request& req, const uuid& operation_id)
+    /* moves the files of a staged operation into place, never replacing
+       existing files; if one cannot be moved, those already moved are put
+       back into the staging directory */
+    int32_t publish_staged(operation& op)
     {
-        // the result of this RPC should be a pair <errorcode, userstatus>
-        std::pair<int32_t, int32_t> result = {0,0};
+        std::vector<std::pair<std::string,std::string>> moved;
+        for(const auto& filename : op.m_fileset.m_files) {
+            auto from = op.m_staging_dir + filename;
+            auto to   = op.m_fileset.m_root + filename;
+            mkdirs(to.substr(0, to.find_last_of('/')).c_str());
+            if(renameNoReplace(from.c_str(), to.c_str()) != 0) {
+                int32_t ret = errno == EEXIST ? REMI_ERR_FILE_EXISTS : REMI_ERR_IO;
+                for(auto& m : moved)
+                    renameNoReplace(m.second.c_str(), m.first.c_str());
+                return ret;
+            }
+            moved.emplace_back(std::move(from), std::move(to));
+        }
+        return REMI_SUCCESS;
+    }
 
-        // get the operation associated with the operation id
-        operation* op = nullptr;
-        {
-            std::lock_guard<tl::mutex> guard(m_op_in_progress_mtx);
-            auto it = m_op_in_progress.find(operation_id);
-            if(it == m_op_in_progress.end()) {
-                result.first = REMI_ERR_INVALID_OPID;
-                req.respond(result);
+    /* reads back the files of an operation that were transferred and
+       compares them with the hashes the client sent; files filled from
+       the dedup index are not read again */
+    int32_t verify_hashes(operation& op)
+    {
+        static constexpr size_t s_hash_ults = 16;
+        std::atomic<bool> ok{true};
+        parallel_io(io_pool(), op.m_fds.size(), s_hash_ults, [this, &op, &ok](size_t i) {
+            if(op.m_hashes[i].empty() || op.m_deduped[i])
                 return;
+            if(hash_file(*op.m_io, op.m_fds[i], op.m_filesizes[i]) != op.m_hashes[i])
+                ok = false;
+        });
+        return ok ? REMI_SUCCESS : REMI_ERR_MIGRATION;
+    }
+
+    /* flushes the data of an operation according to its durability
+       policy; must be called before its files are closed */
+    int32_t make_durable(operation& op)
+    {
+        static constexpr size_t s_sync_ults = 16;
+        std::atomic<bool> ok{true};
+        switch(op.m_durability) {
+        case REMI_DURABILITY_FDATASYNC:
+            parallel_io(io_pool(), op.m_fds.size(), s_sync_ults, [this, &op, &ok](size_t i) {
+                if(op.m_io->fdatasync(op.m_fds[i]) != 0)
+                    ok = false;
+            });
+            break;
+        case REMI_DURABILITY_SYNCFS: {
+            // one syncfs per file system the files live on
+            std::vector<dev_t> synced;
+            for(int fd : op.m_fds) {
+                struct stat st;
+                if(fstat(fd, &st) != 0) {
+                    ok = false;
+                    break;
+                }
+                if(std::find(synced.begin(), synced.end(), st.st_dev) != synced.end())
+                    continue;
+                synced.push_back(st.st_dev);
+                if(syncfs(fd) != 0)
+                    ok = false;
+            }
+            break;
+        }
+        case REMI_DURABILITY_WRITEBACK:
+            // writeback was started as the data arrived, wait for it
+            for(int fd : op.m_fds) {
+                if(sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WAIT_BEFORE
+                        | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER) != 0)
+                    ok = false;
             }
-            op = it->second.get();
+            break;
+        default:
+            break;
         }
+        if(ok)
+            return REMI_SUCCESS;
+        m_stats.m_io_errors += 1;
+        return REMI_ERR_IO;
+    }
+
+    /* starts writing back a range of a file that was just received,
+       if the operation's durability policy asks for it */
+    static void start_writeback(const operation& op, int fd, size_t offset, size_t size)
+    {
+        if(op.m_durability == REMI_DURABILITY_WRITEBACK)
+            sync_file_range(fd, offset, size, SYNC_FILE_RANGE_WRITE);
+    }
+
+    /* fallocates the files of an operation from several ULTs; files on
+       file systems that do not support fallocate are left as they are */
+    int32_t preallocate(io_backend& io, const std::vector<int>& fds,
+                        const std::vector<std::size_t>& sizes, std::vector<char>& preallocated)
+    {
+        static constexpr size_t s_prealloc_ults = 16;
+        std::atomic<int32_t> ret{REMI_SUCCESS};
+        parallel_io(io_pool(), fds.size(), s_prealloc_ults, [&](size_t i) {
+            if(sizes[i] == 0)
+                return;
+            if(io.fallocate(fds[i], 0, sizes[i]) == 0) {
+                preallocated[i] = 1;
+                return;
+            }
+            if(errno == EOPNOTSUPP || errno == ENOSYS || errno == EINVAL)
+                return;
+            ret = (errno == ENOSPC || errno == EDQUOT) ? REMI_ERR_NO_SPACE : REMI_ERR_IO;
+        });
+        return ret;
+    }
+
+    /* ends an operation; its "after" callback may only run in the callback
+       pool if async_callback is set, i.e. if the client was given the id of
+       the operation and can ask for the outcome of the callback */
+    int32_t end_operation(const uuid& operation_id, int32_t* status, int32_t* durability,
+                          bool async_callback = false)
+    {
+        *status = 0;
+        *durability = REMI_DURABILITY_NONE;
+
+        // get the operation associated with the operation id
+        auto op = find_operation(operation_id);
+        if(op == nullptr)
+            return REMI_ERR_INVALID_OPID;
 
+        int32_t ret = REMI_SUCCESS;
+        double t_end = tl::timer::wtime();
         {
             std::lock_guard<tl::mutex> guard(op->m_mutex);
+            m_stats.record_phase(REMI_PHASE_TRANSFER, t_end - op->m_transfer_start);
+
+            // the files are only indexed if they hold what the client hashed
+            if(op->m_error == REMI_SUCCESS && !op->m_hashes.empty()) {
+                op->m_error = verify_hashes(*op);
+                if(op->m_error != REMI_SUCCESS)
+                    std::cerr << "remi-server.cpp: received files do not match their hashes" << std::endl;
+            }
+
+            // flush the data according to the durability policy
+            if(op->m_error == REMI_SUCCESS) {
+                double t_sync = tl::timer::wtime();
+                trace("sync", 'b', operation_id);
+                op->m_error = make_durable(*op);
+                trace("sync", 'e', operation_id);
+                m_stats.record_phase(REMI_PHASE_SYNC, tl::timer::wtime() - t_sync);
+                if(op->m_error == REMI_SUCCESS)
+                    *durability = op->m_durability;
+            }
 
             // close all the file descriptors
-            for(int fd : op->m_fds) {
+            for(int& fd : op->m_fds) {
                 close(fd);
+                fd = -1;
+            }
+
+            // move the staged files into place before the "after" callback sees them
+            if(op->m_error == REMI_SUCCESS && !op->m_staging_dir.empty()) {
+                op->m_error = publish_staged(*op);
+                if(op->m_error == REMI_ERR_IO)
+                    m_stats.m_io_errors += 1;
             }
 
             if(op->m_error != REMI_SUCCESS) {
-                result.first = op->m_error;
-                req.respond(result);
-                std::lock_guard<tl::mutex> guard(m_op_in_progress_mtx);
-                m_op_in_progress.erase(operation_id);
-                return;
+                ret = op->m_error;
+            } else {
+                // find the class of migration
+                auto key = class_key{op->m_fileset.m_class, op->m_fileset.m_provider_id};
+                auto& klass = m_migration_classes[key];
+
+                // call the "after" migration callback associated with the class of fileset,
+                // or have it called in the background once the data is in place
+                if(klass.m_after_callback != nullptr) {
+                    if(async_callback && m_callback_pool.native_handle() != ABT_POOL_NULL) {
+                        start_after_callback(operation_id, key, klass, op->m_fileset);
+                    } else {
+                        trace("after_callback", 'b', operation_id);
+                        *status = klass.m_after_callback(&(op->m_fileset), klass.m_uargs);
+                        trace("after_callback", 'e', operation_id);
+                    }
+                }
+                ret = *status == 0 ? REMI_SUCCESS : REMI_ERR_USER;
+            }
+
+            if(ret == REMI_SUCCESS) {
+                // index the received files so later migrations can reuse them
+                if(!op->m_hashes.empty()) {
+                    unsigned i = 0;
+                    for(const auto& filename : op->m_fileset.m_files) {
+                        if(!op->m_hashes[i].empty())
+                            m_dedup.add(op->m_hashes[i], op->m_fileset.m_root + filename);
+                        i += 1;
+                    }
+                }
+                m_stats.m_migrations += 1;
+                m_stats.m_files_migrated += op->m_fileset.m_files.size();
+                for(auto s : op->m_filesizes)
+                    m_stats.m_bytes_migrated += s;
+            } else {
+                m_stats.m_failed_migrations += 1;
+            }
+        }
+        m_stats.record_phase(REMI_PHASE_END, tl::timer::wtime() - t_end);
+
+        erase_operation(operation_id);
+        return ret;
+    }
+
+    /* calls the "after" callback of a migration from the callback pool,
+       keeping its outcome for remi_callback_status; only the outcomes of
+       the s_max_callback_results most recent callbacks are kept */
+    void start_after_callback(const uuid& operation_id, const class_key& key,
+                              const migration_class& klass, const remi_fileset& fileset)
+    {
+        static constexpr size_t s_max_callback_results = 4096;
+        auto theFileset = std::make_shared<remi_fileset>(fileset);
+        auto callback   = klass.m_after_callback;
+        auto uargs      = klass.m_uargs;
+        {
+            std::lock_guard<tl::mutex> guard(m_callbacks_mtx);
+            m_callbacks[operation_id] = std::make_pair(false, 0);
+            m_callbacks_running += 1;
+            m_class_callbacks_running[key] += 1;
+        }
+        m_callback_pool.make_thread([this, operation_id, key, theFileset, callback, uargs]() {
+            trace("after_callback", 'b', operation_id);
+            int32_t status = callback(theFileset.get(), uargs);
+            trace("after_callback", 'e', operation_id);
+            {
+                std::lock_guard<tl::mutex> guard(m_callbacks_mtx);
+                m_callbacks[operation_id] = std::make_pair(true, status);
+                m_callbacks_done.push_back(operation_id);
+                while(m_callbacks_done.size() > s_max_callback_results) {
+                    m_callbacks.erase(m_callbacks_done.front());
+                    m_callbacks_done.pop_front();
+                }
+                m_callbacks_running -= 1;
+                if(--m_class_callbacks_running[key] == 0)
+                    m_class_callbacks_running.erase(key);
+                // notified with the lock held: once it is released, the
+                // provider may be destroyed by a waiter
+                m_callbacks_cv.notify_all();
             }
+        }, tl::anonymous());
+    }
 
-            // find the class of migration
-            auto key = class_key{op->m_fileset.m_class, op->m_fileset.m_provider_id};
-            auto& klass = m_migration_classes[key];
+    /* waits until no "after" callback runs on the callback pool */
+    void wait_for_callbacks()
+    {
+        std::unique_lock<tl::mutex> lock(m_callbacks_mtx);
+        m_callbacks_cv.wait(lock, [this]() { return m_callbacks_running == 0; });
+    }
+
+    /* waits until no "after" callback of the given class runs on the callback pool */
+    void wait_for_callbacks(const class_key& key)
+    {
+        std::unique_lock<tl::mutex> lock(m_callbacks_mtx);
+        m_callbacks_cv.wait(lock, [this, &key]() {
+            return m_class_callbacks_running.count(key) == 0;
+        });
+    }
 
-            // call the "after" migration callback associated with the class of fileset
-            if(klass.m_after_callback != nullptr) {
-                result.second = klass.m_after_callback(&(op->m_fileset), klass.m_uargs);
+    void callback_status(const tl::request& req, const uuid& operation_id)
+    {
+        // the result of this RPC is a pair <errorcode, userstatus>
+        std::pair<int32_t,int32_t> result{REMI_ERR_INVALID_OPID, 0};
+        {
+            std::lock_guard<tl::mutex> guard(m_callbacks_mtx);
+            auto it = m_callbacks.find(operation_id);
+            if(it != m_callbacks.end()) {
+                if(!it->second.first) {
+                    result.first = REMI_ERR_PENDING;
+                } else {
+                    result.first  = it->second.second == 0 ? REMI_SUCCESS : REMI_ERR_USER;
+                    result.second = it->second.second;
+                    // the outcome is reported once
+                    m_callbacks.erase(it);
+                }
             }
-            result.first = result.second == 0 ? REMI_SUCCESS : REMI_ERR_USER;
+        }
+        req.respond(result);
+    }
+
+    void migrate_start(
+            const tl::request& req,
+            remi_fileset& fileset,
+            std::vector<std::size_t>& filesizes,
+            std::vector<mode_t>& theModes,
+            const std::vector<std::string>& hashes)
+    {
+        // tuple of <returnvalue, userstatus, uuid, indices of deduplicated files>
+        std::tuple<int32_t,int32_t,uuid,std::vector<uint32_t>> result;
+        // uuid is initialized at random, which is what we want
+        std::get<0>(result) = start_operation(
+                std::get<2>(result), fileset, filesizes, theModes, hashes,
+                &std::get<1>(result), &std::get<3>(result));
+        req.respond(result);
+    }
+
+    void migrate_abort(const tl::request& req, const uuid& operation_id)
+    {
+        int32_t ret = abort_operation(operation_id) ? REMI_SUCCESS : REMI_ERR_INVALID_OPID;
+        req.respond(ret);
+    }
+
+    void migrate_end(const tl::request& req, const uuid& operation_id)
+    {
+        // the result of this RPC should be a tuple <errorcode, userstatus, durability>
+        std::tuple<int32_t, int32_t, int32_t> result{0, 0, REMI_DURABILITY_NONE};
+        std::get<0>(result) = end_operation(operation_id, &std::get<1>(result), &std::get<2>(result), true);
+        req.respond(result);
+    }
+
+    /* resolves a path that the provider is asked to read on behalf of a
+       client; fails unless it lies under one of the source roots */
+    bool resolve_source(const std::string& path, std::string* resolved) const
+    {
+        char* real = realpath(path.c_str(), nullptr);
+        if(real == nullptr)
+            return false;
+        *resolved = real;
+        free(real);
+        // a root names itself once given its trailing '/'
+        auto dir = *resolved + '/';
+        for(const auto& root : m_source_roots) {
+            if(dir.compare(0, root.size(), root) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    void migrate_local(
+            const tl::request& req,
+            remi_fileset& fileset,
+            const std::string& source_root,
+            std::vector<std::size_t>& filesizes,
+            std::vector<mode_t>& theModes,
+            const std::vector<std::pair<uint64_t,uint64_t>>& identities,
+            int32_t remove_source)
+    {
+        // the result of this RPC should be a tuple <errorcode, userstatus, durability>
+        std::tuple<int32_t, int32_t, int32_t> result{0, 0, REMI_DURABILITY_NONE};
+
+        if(identities.size() != fileset.m_files.size()
+        || filesizes.size() != fileset.m_files.size()) {
+            std::get<0>(result) = REMI_ERR_INVALID_ARG;
             req.respond(result);
+            return;
+        }
 
+        // open the source files, which must lie under one of the provider's
+        // source roots, and make sure they are the ones the client sees
+        // (same inode, size, and modification time); those on the target's
+        // file system are expected to be linked or cloned rather than copied
+        std::vector<int> sourceFds;
+        std::vector<std::string> sourcePaths;
+        std::vector<char> inPlace;
+        struct stat target_st;
+        bool target_known = stat(existingAncestor(fileset.m_root).c_str(), &target_st) == 0;
+        auto closeSources = [&sourceFds]() {
+            for(int fd : sourceFds)
+                close(fd);
+        };
+        unsigned i = 0;
+        for(const auto& filename : fileset.m_files) {
+            std::string theFilename;
+            int fd = -1;
+            if(resolve_source(source_root + filename, &theFilename))
+                fd = open(theFilename.c_str(), O_RDONLY | O_NOFOLLOW, 0);
+            struct stat st;
+            if(fd == -1 || fstat(fd, &st) != 0
+            || (uint64_t)st.st_ino != identities[i].first
+            || (uint64_t)st.st_mtim.tv_sec*1000000000 + st.st_mtim.tv_nsec != identities[i].second
+            || (size_t)st.st_size != filesizes[i]) {
+                if(fd != -1) close(fd);
+                closeSources();
+                std::get<0>(result) = REMI_ERR_NOT_LOCAL;
+                req.respond(result);
+                return;
+            }
+            sourceFds.push_back(fd);
+            sourcePaths.push_back(std::move(theFilename));
+            inPlace.push_back(target_known && st.st_dev == target_st.st_dev);
+            i += 1;
         }
 
+        // no space is reserved or preallocated for the files that will be
+        // linked or cloned, since they take no new blocks
+        uuid operation_id;
+        std::get<0>(result) = start_operation(operation_id, fileset, filesizes, theModes, {},
+                                              &std::get<1>(result), nullptr, inPlace);
+        if(std::get<0>(result) != REMI_SUCCESS) {
+            closeSources();
+            req.respond(result);
+            return;
+        }
+
+        auto op = find_operation(operation_id);
         {
-            std::lock_guard<tl::mutex> guard(m_op_in_progress_mtx);
-            m_op_in_progress.erase(operation_id);
+            std::lock_guard<tl::mutex> guard(op->m_mutex);
+            i = 0;
+            for(const auto& filename : op->m_fileset.m_files) {
+                int fd = op->m_fds[i];
+                // the client will remove the source, so a hard link is as good
+                // as a copy, and it keeps the source in place should the
+                // "after" callback fail
+                if(remove_source != REMI_KEEP_SOURCE && inPlace[i]) {
+                    auto& theSource = sourcePaths[i];
+                    auto theTarget = op->write_path(filename);
+                    unlink(theTarget.c_str());
+                    if(link(theSource.c_str(), theTarget.c_str()) == 0) {
+                        // the descriptor was left on the unlinked file, reopen
+                        // it on the link so that make_durable flushes the right
+                        // inode
+                        close(fd);
+                        op->m_fds[i] = open(theTarget.c_str(), O_RDWR);
+                        if(op->m_fds[i] == -1) {
+                            m_stats.m_io_errors += 1;
+                            op->m_error = REMI_ERR_IO;
+                            break;
+                        }
+                        op->record_received(i, op->m_filesizes[i]);
+                        i += 1;
+                        continue;
+                    }
+                    // linking failed, recreate the file and copy instead
+                    close(fd);
+                    fd = open(theTarget.c_str(), O_RDWR | O_CREAT | O_TRUNC, op->m_modes[i]);
+                    op->m_fds[i] = fd;
+                    if(fd == -1) {
+                        m_stats.m_io_errors += 1;
+                        op->m_error = REMI_ERR_IO;
+                        break;
+                    }
+                }
+#ifdef FICLONE
+                // a copy that the source is kept for shares its extents if possible
+                else if(inPlace[i] && ioctl(fd, FICLONE, sourceFds[i]) == 0) {
+                    op->record_received(i, op->m_filesizes[i]);
+                    i += 1;
+                    continue;
+                }
+#endif
+                if(inPlace[i] && op->m_filesizes[i] != 0) {
+                    // the file could be neither linked nor cloned, reserve
+                    // the space its copy needs, which was not reserved
+                    dev_t dev;
+                    int32_t r = shared_space_ledger().reserve(op->m_fileset.m_root,
+                            op->m_filesizes[i], 0, &dev);
+                    if(r != REMI_SUCCESS) {
+                        op->m_error = r;
+                        break;
+                    }
+                    if(op->m_space_reserved == 0)
+                        op->m_space_dev = dev;
+                    op->m_space_reserved += op->m_filesizes[i];
+                    op->m_preallocated[i] = 0;
+                }
+                trace("local_copy", 'b', operation_id, i, 0, op->m_filesizes[i]);
+                int copied;
+                {
+                    m_priorities.wait(op->m_fileset.m_priority);
+                    m_throttle.acquire(m_engine, op->m_filesizes[i]);
+                    device_lock dev_lock(op->m_device);
+                    copied = copyFileContent(sourceFds[i], fd, op->m_filesizes[i]);
+                }
+                trace("local_copy", 'e', operation_id, i, 0, op->m_filesizes[i]);
+                if(copied != 0) {
+                    m_stats.m_io_errors += 1;
+                    op->m_error = REMI_ERR_IO;
+                    break;
+                }
+                op->record_received(i, op->m_filesizes[i]);
+                i += 1;
+            }
         }
+        closeSources();
 
-        return;
+        std::get<0>(result) = end_operation(operation_id, &std::get<1>(result), &std::get<2>(result));
+        req.respond(result);
     }
 
     void migrate_mmap(
@@ -229,16 +1077,11 @@ struct remi_provider : public tl::provider<remi_provider> {
     {
         int ret;
         // get the operation associated with the operation id
-        operation* op = nullptr;
-        {
-            std::lock_guard<tl::mutex> guard(m_op_in_progress_mtx);
-            auto it = m_op_in_progress.find(operation_id);
-            if(it == m_op_in_progress.end()) {
-                ret = REMI_ERR_INVALID_OPID;
-                req.respond(ret);
-                return;
-            }
-            op = it->second.get();
+        auto op = find_operation(operation_id);
+        if(op == nullptr) {
+            ret = REMI_ERR_INVALID_OPID;
+            req.respond(ret);
+            return;
         }
         // we found the operation, let's mmap some files!
 
@@ -249,10 +1092,8 @@ struct remi_provider : public tl::provider<remi_provider> {
             for(auto& seg : theData) {
                 munmap(seg.first, seg.second);
             }
-            if(error) {
-                std::lock_guard<tl::mutex> guard(m_op_in_progress_mtx);
-                m_op_in_progress.erase(operation_id);
-            }
+            if(error)
+                abort_operation(operation_id);
         };
 
         // compute total file size
@@ -270,6 +1111,7 @@ struct remi_provider : public tl::provider<remi_provider> {
             if(ftruncate(fd, op->m_filesizes[i]) == -1) {
                 std::cerr << "remi-server.cpp: ftruncate() line "
                     << __LINE__ << " failed with errno " << errno << std::endl;
+                m_stats.m_io_errors += 1;
                 cleanup(true);
                 ret = REMI_ERR_IO;
                 req.respond(ret);
@@ -279,6 +1121,7 @@ struct remi_provider : public tl::provider<remi_provider> {
             if(segment == NULL) {
                 std::cerr << "remi-server.cpp: mmap() line "
                     << __LINE__ << " failed with errno " << errno << std::endl;
+                m_stats.m_io_errors += 1;
                 cleanup(true);
                 ret = REMI_ERR_IO;
                 req.respond(ret);
@@ -292,26 +1135,42 @@ struct remi_provider : public tl::provider<remi_provider> {
         // create a local bulk handle to expose the segments
         auto localBulk = get_engine().expose(theData, tl::bulk_mode::write_only);
 
-        // issue bulk transfer
-        size_t transferred = remote_bulk.on(req.get_endpoint()) >> localBulk;
+        // issue bulk transfers, in pieces so that migrations of a higher
+        // priority can go in between
+        static constexpr size_t s_pull_size = 16*1024*1024;
+        size_t transferred = 0;
+        while(transferred < totalSize) {
+            size_t size = std::min(s_pull_size, totalSize - transferred);
+            m_priorities.wait(op->m_fileset.m_priority);
+            m_throttle.acquire(m_engine, size);
+            trace("server_pull", 'b', operation_id, 0, transferred, size);
+            // no device lock: the pull only dirties pages, the disk is
+            // written when the data is flushed at the end of the migration
+            size_t pulled = remote_bulk(transferred, size).on(req.get_endpoint())
+                          >> localBulk(transferred, size);
+            trace("server_pull", 'e', operation_id, 0, transferred, size);
+            if(pulled != size)
+                break;
+            transferred += size;
+        }
 
         if(transferred != totalSize) {
-            // XXX we should cleanup the files that were created
+            cleanup(true);
             ret = REMI_ERR_MIGRATION;
             req.respond(ret);
             return;
         }
 
-        for(auto& seg : theData) {
-            if(msync(seg.first, seg.second, MS_SYNC) == -1) {
-                cleanup(true);
-                ret = REMI_ERR_IO;
-                req.respond(ret);
-                return;
-            }
+        // the data is flushed according to the durability policy in migrate_end
+        {
+            std::lock_guard<tl::mutex> guard(op->m_mutex);
+            for(unsigned j = 0; j < op->m_filesizes.size(); j++)
+                op->record_received(j, op->m_filesizes[j]);
         }
 
         cleanup(false);
+        for(unsigned j = 0; j < op->m_fds.size(); j++)
+            start_writeback(*op, op->m_fds[j], 0, op->m_filesizes[j]);
         ret = REMI_SUCCESS;
         req.respond(ret);
         return;
@@ -326,16 +1185,12 @@ struct remi_provider : public tl::provider<remi_provider> {
     {
         int ret;
         // get the operation associated with the operation id
-        operation* op = nullptr;
-        {
-            std::lock_guard<tl::mutex> guard(m_op_in_progress_mtx);
-            auto it = m_op_in_progress.find(operation_id);
-            if(it == m_op_in_progress.end()) {
-                ret = REMI_ERR_INVALID_OPID;
-                req.respond(ret);
-                return;
-            }
-            op = it->second.get();
+        remi_provider* owner;
+        auto op = find_striped_operation(operation_id, &owner);
+        if(op == nullptr) {
+            ret = REMI_ERR_INVALID_OPID;
+            req.respond(ret);
+            return;
         }
 
         std::lock_guard<tl::mutex> guard(op->m_mutex);
@@ -345,14 +1200,12 @@ struct remi_provider : public tl::provider<remi_provider> {
         std::vector<int> openedFileDescriptors;
 
         // function to cleanup everything in case of error
-        auto cleanup = [this, &openedFileDescriptors, &operation_id](bool error) {
+        auto cleanup = [owner, &openedFileDescriptors, &operation_id](bool error) {
             for(auto& fd : openedFileDescriptors) {
                 close(fd);
             }
-            if(error) {
-                std::lock_guard<tl::mutex> guard(m_op_in_progress_mtx);
-                this->m_op_in_progress.erase(operation_id);
-            }
+            if(error)
+                owner->abort_operation(operation_id);
         };
 
         // check the RPC's target file index
@@ -376,37 +1229,550 @@ struct remi_provider : public tl::provider<remi_provider> {
         // write the chunk received
         int fd = op->m_fds[fileNumber];
         ssize_t s;
+        double t_chunk = tl::timer::wtime();
         {
             // send an early response so the client can start sending the next chunk
             // in parallel while this chunk is being written
             ret = REMI_SUCCESS;
             req.respond(ret);
 
-            if(m_abtio == ABT_IO_INSTANCE_NULL) {
-                s = pwrite(fd, data.data(), data.size(), writeOffset);
+            owner->m_priorities.wait(op->m_fileset.m_priority);
+            m_throttle.acquire(m_engine, data.size());
+            trace("server_write", 'b', operation_id, fileNumber, writeOffset, data.size());
+            {
+                device_lock dev_lock(op->m_device);
+                s = op->m_io->pwrite(fd, data.data(), data.size(), writeOffset);
+            }
+            trace("server_write", 'e', operation_id, fileNumber, writeOffset, data.size());
+            if(s != (ssize_t)data.size()) {
+                m_stats.m_io_errors += 1;
+                op->m_error = write_error(s);
             } else {
-                s = abt_io_pwrite(m_abtio, fd, data.data(), data.size(), writeOffset);
+                op->record_received(fileNumber, data.size());
+                start_writeback(*op, fd, writeOffset, data.size());
             }
-            if(s != data.size()) {
+        }
+        m_stats.record_chunk(tl::timer::wtime() - t_chunk);
+
+        return;
+    }
+
+    void migrate_bulk_write(
+            const tl::request& req,
+            const uuid& operation_id,
+            uint32_t fileNumber,
+            size_t writeOffset,
+            size_t size,
+            tl::bulk& remote_bulk)
+    {
+        int ret;
+        // get the operation associated with the operation id
+        remi_provider* owner;
+        auto op = find_striped_operation(operation_id, &owner);
+        if(op == nullptr) {
+            ret = REMI_ERR_INVALID_OPID;
+            req.respond(ret);
+            return;
+        }
+
+        double t_chunk = tl::timer::wtime();
+
+        // check the RPC's target file index and the size of the file,
+        // then make sure the file is large enough to be mapped
+        int fd;
+        {
+            std::lock_guard<tl::mutex> guard(op->m_mutex);
+            if(fileNumber >= op->m_fds.size()
+            || op->m_filesizes[fileNumber] < writeOffset + size) {
                 op->m_error = REMI_ERR_IO;
+                owner->abort_operation(operation_id);
+                ret = REMI_ERR_IO;
+                req.respond(ret);
+                return;
+            }
+            fd = op->m_fds[fileNumber];
+            if(op->m_truncated.size() != op->m_fds.size())
+                op->m_truncated.resize(op->m_fds.size(), false);
+            if(!op->m_truncated[fileNumber]) {
+                if(ftruncate(fd, op->m_filesizes[fileNumber]) == -1) {
+                    m_stats.m_io_errors += 1;
+                    op->m_error = REMI_ERR_IO;
+                    owner->abort_operation(operation_id);
+                    ret = REMI_ERR_IO;
+                    req.respond(ret);
+                    return;
+                }
+                op->m_truncated[fileNumber] = true;
             }
         }
 
-        return;
+        if(size == 0) {
+            ret = REMI_SUCCESS;
+            req.respond(ret);
+            return;
+        }
+
+        // map a page-aligned window of the file covering the chunk
+        static const size_t page_size = sysconf(_SC_PAGESIZE);
+        size_t mapOffset = writeOffset - (writeOffset % page_size);
+        size_t mapSize   = size + (writeOffset - mapOffset);
+        void* segment = mmap(0, mapSize, PROT_WRITE | PROT_READ, MAP_SHARED, fd, mapOffset);
+        if(segment == MAP_FAILED) {
+            std::cerr << "remi-server.cpp: mmap() line "
+                << __LINE__ << " failed with errno " << errno << std::endl;
+            m_stats.m_io_errors += 1;
+            op->m_error = REMI_ERR_IO;
+            owner->abort_operation(operation_id);
+            ret = REMI_ERR_IO;
+            req.respond(ret);
+            return;
+        }
+
+        // pull the chunk from the client's buffer directly into the file's pages
+        std::vector<std::pair<void*,std::size_t>> theData(1,
+                {static_cast<char*>(segment) + (writeOffset - mapOffset), size});
+        auto localBulk = get_engine().expose(theData, tl::bulk_mode::write_only);
+        size_t transferred;
+        {
+            owner->m_priorities.wait(op->m_fileset.m_priority);
+            m_throttle.acquire(m_engine, size);
+            trace("server_pull", 'b', operation_id, fileNumber, writeOffset, size);
+            // no device lock: the pull only dirties pages, writeback
+            // reaches the disk outside of this critical section
+            transferred = remote_bulk.on(req.get_endpoint()) >> localBulk;
+        }
+        trace("server_pull", 'e', operation_id, fileNumber, writeOffset, size);
+        munmap(segment, mapSize);
+
+        if(transferred != size) {
+            op->m_error = REMI_ERR_MIGRATION;
+            owner->abort_operation(operation_id);
+            ret = REMI_ERR_MIGRATION;
+        } else {
+            std::lock_guard<tl::mutex> guard(op->m_mutex);
+            op->record_received(fileNumber, size);
+            start_writeback(*op, fd, writeOffset, size);
+            ret = REMI_SUCCESS;
+        }
+        m_stats.record_chunk(tl::timer::wtime() - t_chunk);
+        req.respond(ret);
+    }
+
+    void migrate_batch(
+            const tl::request& req,
+            std::vector<std::tuple<remi_fileset, std::vector<std::size_t>,
+                                   std::vector<mode_t>, std::vector<std::vector<char>>>>& filesets)
+    {
+        // the result of this RPC holds a pair <errorcode, userstatus> per fileset
+        std::vector<std::pair<int32_t,int32_t>> result(filesets.size(), {REMI_SUCCESS, 0});
+        // the filesets are independent, so they are migrated (and their
+        // callbacks called) concurrently
+        static constexpr size_t s_batch_ults = 16;
+        parallel_io(io_pool(), filesets.size(), s_batch_ults, [this, &filesets, &result](size_t k) {
+            auto& f = filesets[k];
+            result[k].first = migrate_inline(std::get<0>(f), std::get<1>(f), std::get<2>(f),
+                                             std::get<3>(f), &result[k].second);
+        });
+        req.respond(result);
+    }
+
+    /* migrates a fileset whose content was sent along with the request */
+    int32_t migrate_inline(
+            remi_fileset& fileset,
+            std::vector<std::size_t>& filesizes,
+            std::vector<mode_t>& theModes,
+            const std::vector<std::vector<char>>& data,
+            int32_t* status)
+    {
+        *status = 0;
+        if(filesizes.size() != fileset.m_files.size()
+        || theModes.size() != fileset.m_files.size()
+        || data.size() != fileset.m_files.size())
+            return REMI_ERR_INVALID_ARG;
+        for(unsigned j = 0; j < data.size(); j++) {
+            if(data[j].size() != filesizes[j])
+                return REMI_ERR_INVALID_ARG;
+        }
+
+        uuid operation_id;
+        int32_t ret = start_operation(operation_id, fileset, filesizes, theModes, {}, status, nullptr);
+        if(ret != REMI_SUCCESS)
+            return ret;
+
+        auto op = find_operation(operation_id);
+        {
+            std::lock_guard<tl::mutex> guard(op->m_mutex);
+            for(unsigned j = 0; j < op->m_fds.size(); j++) {
+                if(data[j].empty())
+                    continue;
+                ssize_t s;
+                {
+                    m_priorities.wait(op->m_fileset.m_priority);
+                    m_throttle.acquire(m_engine, data[j].size());
+                    trace("server_write", 'b', operation_id, j, 0, data[j].size());
+                    device_lock dev_lock(op->m_device);
+                    s = op->m_io->pwrite(op->m_fds[j], data[j].data(), data[j].size(), 0);
+                    trace("server_write", 'e', operation_id, j, 0, data[j].size());
+                }
+                if(s != (ssize_t)data[j].size()) {
+                    m_stats.m_io_errors += 1;
+                    op->m_error = write_error(s);
+                    break;
+                }
+                op->record_received(j, data[j].size());
+            }
+        }
+
+        int32_t durability;
+        return end_operation(operation_id, status, &durability);
+    }
+
+    void pull(
+            const tl::request& req,
+            remi_fileset& fileset,
+            const std::string& source_address,
+            uint16_t source_provider_id,
+            const std::string& local_root)
+    {
+        // the result of this RPC should be a tuple <errorcode, userstatus, durability>
+        std::tuple<int32_t, int32_t, int32_t> result{0, 0, REMI_DURABILITY_NONE};
+
+        // ask the source to open the files of the fileset,
+        // in the form <errorcode, fetch id, files, sizes, modes>
+        tl::provider_handle source;
+        std::tuple<int32_t, uuid, std::vector<std::string>, std::vector<std::size_t>,
+                   std::vector<mode_t>> fetch;
+        try {
+            source = tl::provider_handle(m_engine.lookup(source_address), source_provider_id);
+            fetch  = m_fetch_open_call.on(source)(fileset);
+        } catch(...) {
+            std::get<0>(result) = REMI_ERR_MIGRATION;
+            req.respond(result);
+            return;
+        }
+        if(std::get<0>(fetch) != REMI_SUCCESS) {
+            std::get<0>(result) = std::get<0>(fetch);
+            req.respond(result);
+            return;
+        }
+        auto& fetch_id = std::get<1>(fetch);
+        auto close_source = [this, &source, &fetch_id]() {
+            try {
+                m_fetch_close_call.on(source)(fetch_id);
+            } catch(...) {}
+        };
+
+        // receive the files the source resolved under our own root
+        auto& files = std::get<2>(fetch);
+        fileset.m_files = decltype(fileset.m_files)(files.begin(), files.end());
+        fileset.m_directories = decltype(fileset.m_directories)();
+        fileset.m_root = local_root;
+
+        uuid operation_id;
+        std::get<0>(result) = start_operation(operation_id, fileset, std::get<3>(fetch), std::get<4>(fetch),
+                                              {}, &std::get<1>(result), nullptr);
+        if(std::get<0>(result) != REMI_SUCCESS) {
+            close_source();
+            req.respond(result);
+            return;
+        }
+
+        auto op = find_operation(operation_id);
+        int32_t ret = pull_files(*op, operation_id, source, fetch_id);
+        if(ret != REMI_SUCCESS)
+            op->m_error = ret;
+        close_source();
+
+        std::get<0>(result) = end_operation(operation_id, &std::get<1>(result), &std::get<2>(result));
+        req.respond(result);
+    }
+
+    /* pulls the files of an operation from the source provider that opened
+       them as fetch_id, asking for each piece once the previous one is
+       written, so that the transfer goes at the pace of this provider's
+       storage */
+    int32_t pull_files(operation& op, const uuid& operation_id,
+                       const tl::provider_handle& source, const uuid& fetch_id)
+    {
+        static constexpr size_t s_pull_size = 4*1024*1024;
+        static constexpr size_t s_pull_ults = 4;
+        std::atomic<int32_t> ret{REMI_SUCCESS};
+        parallel_io(io_pool(), op.m_fds.size(), s_pull_ults, [&](size_t i) {
+            size_t size = op.m_filesizes[i];
+            if(size == 0 || ret != REMI_SUCCESS)
+                return;
+            int fd = op.m_fds[i];
+            std::vector<char> buffer(std::min(size, s_pull_size));
+            std::vector<std::pair<void*,std::size_t>> segment(1, {buffer.data(), buffer.size()});
+            auto localBulk = m_engine.expose(segment, tl::bulk_mode::write_only);
+            op.m_io->register_buffer(buffer.data(), buffer.size());
+            for(size_t offset = 0; offset < size && ret == REMI_SUCCESS; ) {
+                size_t n = std::min(size - offset, buffer.size());
+                double t_chunk = tl::timer::wtime();
+                m_priorities.wait(op.m_fileset.m_priority);
+                m_throttle.acquire(m_engine, n);
+                trace("server_pull", 'b', operation_id, i, offset, n);
+                int32_t r;
+                try {
+                    r = m_fetch_read_call.on(source)(fetch_id, (uint32_t)i, offset, n, localBulk);
+                } catch(...) {
+                    r = REMI_ERR_MIGRATION;
+                }
+                trace("server_pull", 'e', operation_id, i, offset, n);
+                if(r != REMI_SUCCESS) {
+                    ret = REMI_ERR_MIGRATION;
+                    break;
+                }
+                ssize_t s;
+                trace("server_write", 'b', operation_id, i, offset, n);
+                {
+                    device_lock dev_lock(op.m_device);
+                    s = op.m_io->pwrite(fd, buffer.data(), n, offset);
+                }
+                trace("server_write", 'e', operation_id, i, offset, n);
+                if(s != (ssize_t)n) {
+                    m_stats.m_io_errors += 1;
+                    ret = write_error(s);
+                    break;
+                }
+                {
+                    std::lock_guard<tl::mutex> guard(op.m_mutex);
+                    op.record_received(i, n);
+                }
+                start_writeback(op, fd, offset, n);
+                m_stats.record_chunk(tl::timer::wtime() - t_chunk);
+                offset += n;
+            }
+            op.m_io->deregister_buffer(buffer.data());
+        });
+        return ret;
+    }
+
+    static void list_file(const char* filename, void* uargs) {
+        static_cast<std::vector<std::string>*>(uargs)->emplace_back(filename);
+    }
+
+    /* time a fetch may go without a read before it is dropped */
+    static constexpr double s_fetch_lifetime = 600.0;
+
+    /* drops the fetches whose destination did not read or close them in time */
+    void expire_fetches()
+    {
+        std::vector<std::shared_ptr<fetch_source>> expired;
+        {
+            double now = tl::timer::wtime();
+            std::lock_guard<tl::mutex> guard(m_fetches_mtx);
+            for(auto it = m_fetches.begin(); it != m_fetches.end(); ) {
+                if(it->second->m_expires > now) {
+                    ++it;
+                    continue;
+                }
+                expired.push_back(std::move(it->second));
+                it = m_fetches.erase(it);
+            }
+        }
+    }
+
+    /* opens the files of a fileset another provider wants to pull, which it
+       then reads with remi_fetch_read until it calls remi_fetch_close or
+       stops reading for s_fetch_lifetime seconds; the class of the fileset
+       must be registered with this provider and the files must be under
+       its source roots */
+    void fetch_open(const tl::request& req, remi_fileset& fileset)
+    {
+        // tuple of <errorcode, fetch id, files, sizes, modes>
+        std::tuple<int32_t, uuid, std::vector<std::string>, std::vector<std::size_t>,
+                   std::vector<mode_t>> result;
+        expire_fetches();
+
+        auto key = class_key{fileset.m_class, fileset.m_provider_id};
+        if(m_migration_classes.count(key) == 0) {
+            std::get<0>(result) = REMI_ERR_UNKNOWN_CLASS;
+            req.respond(result);
+            return;
+        }
+        std::string theRoot;
+        if(!resolve_source(fileset.m_root, &theRoot)) {
+            std::get<0>(result) = REMI_ERR_UNKNOWN_FILE;
+            req.respond(result);
+            return;
+        }
+
+        auto& files = std::get<2>(result);
+        remi_fileset_walkthrough(&fileset, list_file, static_cast<void*>(&files));
+
+        auto fetch = std::make_shared<fetch_source>();
+        for(const auto& filename : files) {
+            std::string theFilename;
+            int fd = -1;
+            if(resolve_source(fileset.m_root + filename, &theFilename))
+                fd = open(theFilename.c_str(), O_RDONLY | O_NOFOLLOW, 0);
+            struct stat st;
+            if(fd == -1 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+                if(fd != -1) close(fd);
+                std::get<0>(result) = REMI_ERR_UNKNOWN_FILE;
+                req.respond(result);
+                return;
+            }
+            std::get<3>(result).push_back(st.st_size);
+            std::get<4>(result).push_back(st.st_mode);
+            if(st.st_size == 0) {
+                close(fd);
+                fd = -1;
+            }
+            fetch->m_fds.push_back(fd);
+            fetch->m_sizes.push_back(st.st_size);
+        }
+        fetch->m_expires = tl::timer::wtime() + s_fetch_lifetime;
+        {
+            // the fetch id is initialized at random
+            std::lock_guard<tl::mutex> guard(m_fetches_mtx);
+            m_fetches.emplace(std::get<1>(result), std::move(fetch));
+        }
+        std::get<0>(result) = REMI_SUCCESS;
+        req.respond(result);
+    }
+
+    /* reads a piece of a file opened by fetch_open and pushes it into the
+       buffer the destination exposed; only one piece per request is held
+       in memory */
+    void fetch_read(
+            const tl::request& req,
+            const uuid& fetch_id,
+            uint32_t fileNumber,
+            size_t offset,
+            size_t size,
+            tl::bulk& remote_bulk)
+    {
+        static constexpr size_t s_max_read_size = 16*1024*1024;
+        int32_t ret = REMI_ERR_INVALID_OPID;
+        std::shared_ptr<fetch_source> fetch;
+        {
+            std::lock_guard<tl::mutex> guard(m_fetches_mtx);
+            auto it = m_fetches.find(fetch_id);
+            if(it != m_fetches.end()) {
+                fetch = it->second;
+                fetch->m_expires = tl::timer::wtime() + s_fetch_lifetime;
+            }
+        }
+        if(!fetch) {
+            req.respond(ret);
+            return;
+        }
+        if(fileNumber >= fetch->m_fds.size() || size > s_max_read_size
+        || offset + size > fetch->m_sizes[fileNumber] || remote_bulk.size() < size) {
+            ret = REMI_ERR_INVALID_ARG;
+            req.respond(ret);
+            return;
+        }
+        if(size == 0) {
+            ret = REMI_SUCCESS;
+            req.respond(ret);
+            return;
+        }
+
+        std::vector<char> buffer(size);
+        m_throttle.acquire(m_engine, size);
+        trace("fetch_read", 'b', fetch_id, fileNumber, offset, size);
+        size_t read_size = read_chunk(*current_io(), fetch->m_fds[fileNumber], buffer.data(), size, offset);
+        trace("fetch_read", 'e', fetch_id, fileNumber, offset, size);
+        if(read_size != size) {
+            // the file shrank since it was opened
+            m_stats.m_io_errors += 1;
+            ret = REMI_ERR_IO;
+            req.respond(ret);
+            return;
+        }
+        std::vector<std::pair<void*,std::size_t>> segment(1, {buffer.data(), buffer.size()});
+        auto localBulk = m_engine.expose(segment, tl::bulk_mode::read_only);
+        remote_bulk(0, size).on(req.get_endpoint()) << localBulk;
+        ret = REMI_SUCCESS;
+        req.respond(ret);
+    }
+
+    void fetch_close(const tl::request& req, const uuid& fetch_id)
+    {
+        int32_t ret = REMI_ERR_INVALID_OPID;
+        std::shared_ptr<fetch_source> fetch;
+        {
+            std::lock_guard<tl::mutex> guard(m_fetches_mtx);
+            auto it = m_fetches.find(fetch_id);
+            if(it != m_fetches.end()) {
+                fetch = std::move(it->second);
+                m_fetches.erase(it);
+                ret = REMI_SUCCESS;
+            }
+        }
+        expire_fetches();
+        req.respond(ret);
+    }
+
+    void migrate_status(const tl::request& req, const uuid& operation_id)
+    {
+        // the result of this RPC is a tuple <errorcode, bytes total, bytes received,
+        // files total, files completed, seconds elapsed>
+        std::tuple<int32_t,uint64_t,uint64_t,uint64_t,uint64_t,double> result{
+            REMI_ERR_INVALID_OPID, 0, 0, 0, 0, 0.0};
+        auto op = find_operation(operation_id);
+        if(op != nullptr) {
+            std::lock_guard<tl::mutex> guard(op->m_mutex);
+            uint64_t bytes_total = 0;
+            for(auto s : op->m_filesizes)
+                bytes_total += s;
+            result = std::make_tuple((int32_t)REMI_SUCCESS, bytes_total, op->m_bytes_received,
+                    (uint64_t)op->m_filesizes.size(), op->m_files_completed,
+                    tl::timer::wtime() - op->m_transfer_start);
+        }
+        req.respond(result);
+    }
+
+    tl::pool io_pool() const {
+        if(m_io_pool.native_handle() != ABT_POOL_NULL)
+            return m_io_pool;
+        if(m_data_pool.native_handle() != ABT_POOL_NULL)
+            return m_data_pool;
+        return m_engine.get_handler_pool();
+    }
+
+    std::unique_ptr<io_backend> make_io(int type) const {
+        return make_io_backend(type, m_abtio, REMI_IO_POSIX, m_io_pool);
     }
 
-    remi_provider(tl::engine e, abt_io_instance_id abtio, uint16_t provider_id, tl::pool& pool)
-    : tl::provider<remi_provider>(e, provider_id, "remi"), m_engine(e), m_pool(pool), m_abtio(abtio)
-    , m_migration_start_rpc(define("remi_migrate_start", &remi_provider::migrate_start, pool))
-    , m_migration_mmap_rpc(define("remi_migrate_mmap", &remi_provider::migrate_mmap, pool))
-    , m_migration_write_rpc(define("remi_migrate_write", &remi_provider::migrate_write, pool))
-    , m_migration_end_rpc(define("remi_migrate_end", &remi_provider::migrate_end, pool))
+    remi_provider(tl::engine e, abt_io_instance_id abtio, uint16_t provider_id,
+                  const tl::pool& control_pool, const tl::pool& data_pool, const tl::pool& io_pool)
+    : tl::provider<remi_provider>(e, provider_id, "remi"), m_engine(e)
+    , m_pool(control_pool), m_data_pool(data_pool), m_io_pool(io_pool), m_abtio(abtio)
+    , m_migration_start_rpc(define("remi_migrate_start", &remi_provider::migrate_start, control_pool))
+    , m_migration_mmap_rpc(define("remi_migrate_mmap", &remi_provider::migrate_mmap, data_pool))
+    , m_migration_write_rpc(define("remi_migrate_write", &remi_provider::migrate_write, data_pool))
+    , m_migration_bulk_write_rpc(define("remi_migrate_bulk_write", &remi_provider::migrate_bulk_write, data_pool))
+    , m_migration_end_rpc(define("remi_migrate_end", &remi_provider::migrate_end, control_pool))
+    , m_migration_abort_rpc(define("remi_migrate_abort", &remi_provider::migrate_abort, control_pool))
+    , m_migration_local_rpc(define("remi_migrate_local", &remi_provider::migrate_local, data_pool))
+    , m_migration_status_rpc(define("remi_migrate_status", &remi_provider::migrate_status, control_pool))
+    , m_pull_rpc(define("remi_pull", &remi_provider::pull, data_pool))
+    , m_migration_batch_rpc(define("remi_migrate_batch", &remi_provider::migrate_batch, data_pool))
+    , m_callback_status_rpc(define("remi_callback_status", &remi_provider::callback_status, control_pool))
+    , m_fetch_open_rpc(define("remi_fetch_open", &remi_provider::fetch_open, control_pool))
+    , m_fetch_read_rpc(define("remi_fetch_read", &remi_provider::fetch_read, data_pool))
+    , m_fetch_close_rpc(define("remi_fetch_close", &remi_provider::fetch_close, control_pool))
+    , m_fetch_open_call(e.define("remi_fetch_open"))
+    , m_fetch_read_call(e.define("remi_fetch_read"))
+    , m_fetch_close_call(e.define("remi_fetch_close"))
     {
+        set_io(make_io(REMI_IO_DEFAULT));
+        std::lock_guard<tl::mutex> guard(registered_providers_mutex());
         s_registered_providers[provider_id] = this;
     }
 
     ~remi_provider() {
-        s_registered_providers.erase(get_provider_id());
+        {
+            std::lock_guard<tl::mutex> guard(registered_providers_mutex());
+            s_registered_providers.erase(get_provider_id());
+        }
+        // callbacks still running use the provider
+        wait_for_callbacks();
+        m_fetches.clear();
     }
 
 };
@@ -415,6 +1781,8 @@ std::unordered_map<uint16_t, remi_provider*> remi_provider::s_registered_provide
 
 static void remi_on_finalize(void* uargs) {
     auto provider = static_cast<remi_provider_t>(uargs);
+    // the arguments of the classes are in use until their callbacks return
+    provider->wait_for_callbacks();
     for(auto& klass : provider->m_migration_classes) {
         if(klass.second.m_free != nullptr) {
             klass.second.m_free(klass.second.m_uargs);
@@ -430,8 +1798,21 @@ extern "C" int remi_provider_register(
         ABT_pool pool,
         remi_provider_t* provider)
 {
-    auto thePool   = tl::pool(pool);
-    auto theProvider = new remi_provider(tl::engine(mid), abtio, provider_id, thePool);
+    return remi_provider_register_with_pools(
+            mid, abtio, provider_id, pool, pool, ABT_POOL_NULL, provider);
+}
+
+extern "C" int remi_provider_register_with_pools(
+        margo_instance_id mid,
+        abt_io_instance_id abtio,
+        uint16_t provider_id,
+        ABT_pool control_pool,
+        ABT_pool data_pool,
+        ABT_pool io_pool,
+        remi_provider_t* provider)
+{
+    auto theProvider = new remi_provider(tl::engine(mid), abtio, provider_id,
+            tl::pool(control_pool), tl::pool(data_pool), tl::pool(io_pool));
     margo_provider_push_finalize_callback(mid, theProvider, remi_on_finalize, theProvider);
     *provider = theProvider;
     return REMI_SUCCESS;
@@ -462,6 +1843,8 @@ extern "C" int remi_provider_registered(
         ABT_pool* pool,
         remi_provider_t* provider)
 {
+    (void)mid;
+    std::lock_guard<tl::mutex> guard(remi_provider::registered_providers_mutex());
     auto it = remi_provider::s_registered_providers.find(provider_id);
     if(it == remi_provider::s_registered_providers.end()) {
         if(pool) *pool = ABT_POOL_NULL;
@@ -482,9 +1865,130 @@ extern "C" int remi_provider_set_abt_io_instance(
         abt_io_instance_id abtio)
 {
     provider->m_abtio = abtio;
+    // migrations in progress keep the backend they started with
+    auto io = provider->make_io(provider->m_io_type);
+    if(io) provider->set_io(std::move(io));
     return REMI_SUCCESS;
 }
 
+extern "C" int remi_provider_set_io_backend(
+        remi_provider_t provider,
+        int backend)
+{
+    if(provider == REMI_PROVIDER_NULL)
+        return REMI_ERR_INVALID_ARG;
+    auto io = provider->make_io(backend);
+    if(!io)
+        return REMI_ERR_INVALID_ARG;
+    provider->m_io_type = backend;
+    provider->set_io(std::move(io));
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_provider_set_durability(
+        remi_provider_t provider,
+        int policy)
+{
+    if(provider == REMI_PROVIDER_NULL
+    || policy < REMI_DURABILITY_NONE
+    || policy > REMI_DURABILITY_WRITEBACK)
+        return REMI_ERR_INVALID_ARG;
+    provider->m_durability = policy;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_provider_set_rate_limit(
+        remi_provider_t provider,
+        uint64_t bytes_per_sec,
+        uint64_t ops_per_sec)
+{
+    if(provider == REMI_PROVIDER_NULL)
+        return REMI_ERR_INVALID_ARG;
+    provider->m_throttle.m_bytes.set_rate(bytes_per_sec);
+    provider->m_throttle.m_ops.set_rate(ops_per_sec);
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_provider_set_max_concurrent_migrations(
+        remi_provider_t provider,
+        uint32_t max)
+{
+    if(provider == REMI_PROVIDER_NULL)
+        return REMI_ERR_INVALID_ARG;
+    provider->m_admission.set_max(max);
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_provider_set_operation_timeout(
+        remi_provider_t provider,
+        double seconds)
+{
+    if(provider == REMI_PROVIDER_NULL || seconds < 0.0)
+        return REMI_ERR_INVALID_ARG;
+    provider->m_op_timeout = seconds;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_provider_add_source_root(
+        remi_provider_t provider,
+        const char* root)
+{
+    if(provider == REMI_PROVIDER_NULL || root == NULL)
+        return REMI_ERR_INVALID_ARG;
+    char* real = realpath(root, nullptr);
+    if(real == nullptr)
+        return REMI_ERR_UNKNOWN_FILE;
+    std::string theRoot(real);
+    free(real);
+    if(theRoot[theRoot.size()-1] != '/')
+        theRoot += "/";
+    provider->m_source_roots.push_back(std::move(theRoot));
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_provider_set_callback_pool(
+        remi_provider_t provider,
+        ABT_pool pool)
+{
+    if(provider == REMI_PROVIDER_NULL)
+        return REMI_ERR_INVALID_ARG;
+    provider->m_callback_pool = tl::pool(pool);
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_provider_enable_dedup(
+        remi_provider_t provider,
+        const char* index_path,
+        int allow_hardlinks)
+{
+    if(provider == REMI_PROVIDER_NULL || index_path == NULL)
+        return REMI_ERR_INVALID_ARG;
+    if(!provider->m_dedup.open(index_path))
+        return REMI_ERR_IO;
+    provider->m_dedup.m_allow_hardlinks = allow_hardlinks != 0;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_provider_get_stats(
+        remi_provider_t provider,
+        remi_stats_t* stats)
+{
+    if(provider == REMI_PROVIDER_NULL || stats == NULL)
+        return REMI_ERR_INVALID_ARG;
+    provider->m_stats.snapshot(stats);
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_provider_get_stats_json(
+        remi_provider_t provider,
+        char* buf,
+        size_t* size)
+{
+    if(provider == REMI_PROVIDER_NULL || size == NULL)
+        return REMI_ERR_INVALID_ARG;
+    return copy_string_out(provider->m_stats.to_json(), buf, size);
+}
+
 extern "C" int remi_provider_register_migration_class(
         remi_provider_t provider,
         const char* class_name,
@@ -539,6 +2043,7 @@ extern "C" int remi_provider_deregister_provider_migration_class(
     auto key = class_key{class_name, provider_id};
     if(provider->m_migration_classes.count(key) == 0)
         return REMI_ERR_UNKNOWN_CLASS;
+    provider->wait_for_callbacks(key);
     auto& klass = provider->m_migration_classes[key];
     if(klass.m_free) klass.m_free(klass.m_uargs);
     provider->m_migration_classes.erase(key);
@@ -549,5 +2054,19 @@ extern "C" int remi_set_device(
         const char* mount_point,
         int type)
 {
+    if(mount_point == NULL
+    || (type != REMI_DEVICE_MEM && type != REMI_DEVICE_HDD && type != REMI_DEVICE_SSD))
+        return REMI_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard(s_devices_mtx);
+    // the type of a registered device cannot change, since migrations
+    // in progress may hold its lock
+    for(auto& dev : s_devices) {
+        if(dev->m_mount_point == mount_point)
+            return dev->m_type == type ? REMI_SUCCESS : REMI_ERR_INVALID_ARG;
+    }
+    auto dev = std::make_unique<device>();
+    dev->m_mount_point = mount_point;
+    dev->m_type        = type;
+    s_devices.push_back(std::move(dev));
     return REMI_SUCCESS;
 }
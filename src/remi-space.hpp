@@ -0,0 +1,71 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __REMI_SPACE_HPP
+#define __REMI_SPACE_HPP
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <thallium.hpp>
+#include "remi/remi-common.h"
+#include "fs-util.hpp"
+
+namespace tl = thallium;
+
+/**
+ * Space promised to the migrations in progress but not allocated on disk
+ * yet, per file system, shared by all the providers of the process.
+ * A migration reserves its announced size when it starts; its reservation
+ * shrinks as its files are preallocated or as its data is written.
+ */
+class space_ledger {
+
+    tl::mutex                           m_mutex;
+    std::unordered_map<dev_t, uint64_t> m_reserved;
+
+    public:
+
+    /* reserves size bytes and files inodes on the file system that holds
+       path, if they fit next to the other reservations; file systems that
+       do not report their capacity are not checked */
+    int32_t reserve(const std::string& path, uint64_t size, uint64_t files, dev_t* dev) {
+        auto existing = existingAncestor(path);
+        struct stat st;
+        struct statvfs vfs;
+        if(stat(existing.c_str(), &st) != 0 || statvfs(existing.c_str(), &vfs) != 0)
+            return REMI_ERR_IO;
+        *dev = st.st_dev;
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        uint64_t& reserved = m_reserved[st.st_dev];
+        if(vfs.f_blocks != 0) {
+            uint64_t available = (uint64_t)vfs.f_bavail * vfs.f_frsize;
+            if(reserved > available || size > available - reserved
+            || (vfs.f_files != 0 && files > vfs.f_favail)) {
+                if(reserved == 0)
+                    m_reserved.erase(st.st_dev);
+                return REMI_ERR_NO_SPACE;
+            }
+        }
+        reserved += size;
+        return REMI_SUCCESS;
+    }
+
+    void release(dev_t dev, uint64_t size) {
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        auto it = m_reserved.find(dev);
+        if(it == m_reserved.end())
+            return;
+        it->second -= std::min(size, it->second);
+        if(it->second == 0)
+            m_reserved.erase(it);
+    }
+};
+
+#endif
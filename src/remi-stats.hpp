@@ -0,0 +1,116 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __REMI_STATS_HPP
+#define __REMI_STATS_HPP
+
+#include <atomic>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include "remi/remi-common.h"
+
+/**
+ * Counters behind remi_stats_t, updated without locks from the
+ * ULTs running migrations.
+ */
+struct stats_counters {
+
+    std::atomic<uint64_t> m_bytes_migrated{0};
+    std::atomic<uint64_t> m_files_migrated{0};
+    std::atomic<uint64_t> m_migrations{0};
+    std::atomic<uint64_t> m_failed_migrations{0};
+    std::atomic<uint64_t> m_active_operations{0};
+    std::atomic<uint64_t> m_io_errors{0};
+    std::atomic<uint64_t> m_phase_count[REMI_NUM_PHASES] = {};
+    std::atomic<uint64_t> m_phase_total_us[REMI_NUM_PHASES] = {};
+    std::atomic<uint64_t> m_phase_max_us[REMI_NUM_PHASES] = {};
+    std::atomic<uint64_t> m_chunks{0};
+    std::atomic<uint64_t> m_chunk_latency[REMI_STATS_NUM_BUCKETS] = {};
+
+    static uint64_t to_us(double seconds) {
+        return seconds > 0.0 ? static_cast<uint64_t>(seconds * 1e6) : 0;
+    }
+
+    void record_phase(int phase, double seconds) {
+        uint64_t us = to_us(seconds);
+        m_phase_count[phase] += 1;
+        m_phase_total_us[phase] += us;
+        uint64_t max = m_phase_max_us[phase].load();
+        while(us > max && !m_phase_max_us[phase].compare_exchange_weak(max, us));
+    }
+
+    void record_chunk(double seconds) {
+        uint64_t us = to_us(seconds);
+        unsigned bucket = 0;
+        while(us > 1 && bucket < REMI_STATS_NUM_BUCKETS - 1) {
+            us >>= 1;
+            bucket += 1;
+        }
+        m_chunks += 1;
+        m_chunk_latency[bucket] += 1;
+    }
+
+    void snapshot(remi_stats_t* stats) const {
+        stats->bytes_migrated    = m_bytes_migrated;
+        stats->files_migrated    = m_files_migrated;
+        stats->migrations        = m_migrations;
+        stats->failed_migrations = m_failed_migrations;
+        stats->active_operations = m_active_operations;
+        stats->io_errors         = m_io_errors;
+        for(int i = 0; i < REMI_NUM_PHASES; i++) {
+            stats->phases[i].count    = m_phase_count[i];
+            stats->phases[i].total_us = m_phase_total_us[i];
+            stats->phases[i].max_us   = m_phase_max_us[i];
+        }
+        stats->chunks = m_chunks;
+        for(int i = 0; i < REMI_STATS_NUM_BUCKETS; i++)
+            stats->chunk_latency[i] = m_chunk_latency[i];
+    }
+
+    std::string to_json() const {
+        static const char* phase_names[REMI_NUM_PHASES] = { "start", "transfer", "sync", "end" };
+        remi_stats_t s;
+        snapshot(&s);
+        std::ostringstream ss;
+        ss << "{\"bytes_migrated\":" << s.bytes_migrated
+           << ",\"files_migrated\":" << s.files_migrated
+           << ",\"migrations\":" << s.migrations
+           << ",\"failed_migrations\":" << s.failed_migrations
+           << ",\"active_operations\":" << s.active_operations
+           << ",\"io_errors\":" << s.io_errors
+           << ",\"phases\":{";
+        for(int i = 0; i < REMI_NUM_PHASES; i++) {
+            ss << (i ? "," : "") << "\"" << phase_names[i] << "\":{"
+               << "\"count\":" << s.phases[i].count
+               << ",\"total_us\":" << s.phases[i].total_us
+               << ",\"max_us\":" << s.phases[i].max_us << "}";
+        }
+        ss << "},\"chunks\":" << s.chunks << ",\"chunk_latency_us_log2\":[";
+        for(int i = 0; i < REMI_STATS_NUM_BUCKETS; i++)
+            ss << (i ? "," : "") << s.chunk_latency[i];
+        ss << "]}";
+        return ss.str();
+    }
+};
+
+/**
+ * Copies a string out following the convention of remi_fileset_get_class:
+ * if buf is NULL, only the required size is returned.
+ */
+inline int copy_string_out(const std::string& str, char* buf, size_t* size)
+{
+    if(buf == nullptr) {
+        *size = str.size()+1;
+        return REMI_SUCCESS;
+    } else if(*size < str.size()+1) {
+        return REMI_ERR_SIZE;
+    }
+    std::memcpy(buf, str.c_str(), str.size()+1);
+    *size = str.size()+1;
+    return REMI_SUCCESS;
+}
+
+#endif
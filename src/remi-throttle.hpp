@@ -0,0 +1,213 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __REMI_THROTTLE_HPP
+#define __REMI_THROTTLE_HPP
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <time.h>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+/**
+ * Token bucket refilled at a given rate (tokens per second), holding at
+ * most one second worth of tokens. A caller asking for more tokens than
+ * available takes them anyway, leaving the bucket in debt, and sleeps
+ * until the debt it created is repaid; this keeps requests larger than
+ * the bucket possible and preserves their order. A rate of 0 disables
+ * the bucket.
+ */
+class token_bucket {
+
+    tl::mutex m_mutex;
+    double    m_rate   = 0.0;
+    double    m_tokens = 0.0;
+    double    m_last   = 0.0;
+
+    public:
+
+    void set_rate(double rate) {
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        m_rate   = rate;
+        m_tokens = rate;
+        m_last   = tl::timer::wtime();
+    }
+
+    double rate() {
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        return m_rate;
+    }
+
+    void acquire(const tl::engine& engine, double n) {
+        double wait = 0.0;
+        {
+            std::lock_guard<tl::mutex> guard(m_mutex);
+            if(m_rate == 0.0) return;
+            double now = tl::timer::wtime();
+            m_tokens = std::min(m_rate, m_tokens + (now - m_last) * m_rate);
+            m_last   = now;
+            m_tokens -= n;
+            if(m_tokens < 0.0)
+                wait = -m_tokens / m_rate;
+        }
+        if(wait > 0.0)
+            tl::thread::sleep(engine, wait * 1000.0);
+    }
+};
+
+/**
+ * Bandwidth and IOPS limits applied to the I/O of a client or provider.
+ */
+struct throttle {
+
+    token_bucket m_bytes;
+    token_bucket m_ops;
+
+    void acquire(const tl::engine& engine, size_t bytes) {
+        m_ops.acquire(engine, 1.0);
+        m_bytes.acquire(engine, bytes);
+    }
+};
+
+/**
+ * Caps the number of concurrent operations. Operations beyond the
+ * cap wait in FIFO order for a slot instead of failing. A cap of 0
+ * means unlimited.
+ */
+class admission_gate {
+
+    tl::mutex              m_mutex;
+    tl::condition_variable m_cv;
+    size_t                 m_max     = 0;
+    size_t                 m_active  = 0;
+    uint64_t               m_next    = 0; // next ticket to hand out
+    uint64_t               m_serving = 0; // next ticket to admit
+
+    public:
+
+    void set_max(size_t max) {
+        {
+            std::lock_guard<tl::mutex> guard(m_mutex);
+            m_max = max;
+        }
+        m_cv.notify_all();
+    }
+
+    void enter() {
+        std::unique_lock<tl::mutex> lock(m_mutex);
+        uint64_t ticket = m_next++;
+        m_cv.wait(lock, [this, ticket]() {
+            return ticket == m_serving && (m_max == 0 || m_active < m_max);
+        });
+        m_serving += 1;
+        m_active  += 1;
+        lock.unlock();
+        // let the next ticket check whether it can be admitted too
+        m_cv.notify_all();
+    }
+
+    /* same as enter(), calling on_wait() without the gate's lock held
+       every period seconds while waiting, e.g. to reclaim the slots of
+       operations that were abandoned; the caller keeps its place */
+    template<typename F>
+    void enter(double period, F&& on_wait) {
+        std::unique_lock<tl::mutex> lock(m_mutex);
+        uint64_t ticket = m_next++;
+        while(!(ticket == m_serving && (m_max == 0 || m_active < m_max))) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec  += (time_t)period;
+            deadline.tv_nsec += (long)((period - (time_t)period) * 1e9);
+            if(deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec  += 1;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            if(!m_cv.wait_until(lock, &deadline)) {
+                lock.unlock();
+                on_wait();
+                lock.lock();
+            }
+        }
+        m_serving += 1;
+        m_active  += 1;
+        lock.unlock();
+        m_cv.notify_all();
+    }
+
+    void leave() {
+        {
+            std::lock_guard<tl::mutex> guard(m_mutex);
+            m_active -= 1;
+        }
+        m_cv.notify_all();
+    }
+};
+
+/**
+ * Lets transfers of a higher priority go first. Each migration registers
+ * its priority for its whole duration (from migrate_start to migrate_end
+ * on a provider) and waits before each of its chunks as long as
+ * migrations of a higher priority are registered, so ongoing low-priority
+ * migrations pause until the urgent ones are done, including between
+ * their chunks. Transfers of equal priority do not wait for each other.
+ */
+class priority_gate {
+
+    tl::mutex                 m_mutex;
+    tl::condition_variable    m_cv;
+    std::map<int32_t, size_t> m_count; // registered transfers per priority
+
+    /* must be called with m_mutex held */
+    bool can_run(int32_t priority) const {
+        return m_count.empty() || m_count.rbegin()->first <= priority;
+    }
+
+    public:
+
+    void add(int32_t priority) {
+        std::lock_guard<tl::mutex> guard(m_mutex);
+        m_count[priority] += 1;
+    }
+
+    void remove(int32_t priority) {
+        {
+            std::lock_guard<tl::mutex> guard(m_mutex);
+            auto it = m_count.find(priority);
+            if(it == m_count.end()) return;
+            if(--it->second == 0)
+                m_count.erase(it);
+        }
+        m_cv.notify_all();
+    }
+
+    void wait(int32_t priority) {
+        std::unique_lock<tl::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this, priority]() { return can_run(priority); });
+    }
+
+    void enter(int32_t priority) {
+        std::unique_lock<tl::mutex> lock(m_mutex);
+        m_count[priority] += 1;
+        m_cv.wait(lock, [this, priority]() { return can_run(priority); });
+    }
+
+    void leave(int32_t priority) {
+        remove(priority);
+    }
+};
+
+/* holds a priority_gate for the duration of a transfer */
+struct priority_slot {
+    priority_gate& m_gate;
+    int32_t        m_priority;
+    priority_slot(priority_gate& gate, int32_t priority)
+    : m_gate(gate), m_priority(priority) { m_gate.enter(m_priority); }
+    ~priority_slot() { m_gate.leave(m_priority); }
+};
+
+#endif
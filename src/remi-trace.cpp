@@ -0,0 +1,131 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "remi/remi-common.h"
+#include "remi-trace.hpp"
+
+std::atomic<bool> g_trace_enabled{false};
+
+namespace {
+
+/**
+ * Ring of events written by a single execution stream (ULTs do not
+ * yield while recording an event, so each ring has a single writer).
+ * The oldest events are overwritten once the ring is full.
+ */
+struct trace_ring {
+    std::vector<trace_event> m_events;
+    std::atomic<uint64_t>    m_next{0};
+    unsigned                 m_index;
+
+    trace_ring(size_t capacity, unsigned index)
+    : m_events(capacity), m_index(index) {}
+};
+
+std::mutex                               s_rings_mtx;
+std::vector<std::unique_ptr<trace_ring>> s_rings;
+size_t                                   s_capacity = 0;
+thread_local trace_ring*                 t_ring = nullptr;
+
+trace_ring* get_ring()
+{
+    if(t_ring) return t_ring;
+    std::lock_guard<std::mutex> guard(s_rings_mtx);
+    s_rings.push_back(std::make_unique<trace_ring>(s_capacity, s_rings.size()));
+    t_ring = s_rings.back().get();
+    return t_ring;
+}
+
+uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+}
+
+void trace_record(const char* name, char phase, const uuid& op,
+                  uint32_t file, uint64_t offset, uint64_t size)
+{
+    trace_ring* ring = get_ring();
+    uint64_t n = ring->m_next.load(std::memory_order_relaxed);
+    auto& e = ring->m_events[n % ring->m_events.size()];
+    e.m_name      = name;
+    e.m_phase     = phase;
+    e.m_timestamp = now_ns();
+    for(unsigned i = 0; i < 16; i++)
+        e.m_op[i] = op[i];
+    e.m_file      = file;
+    e.m_offset    = offset;
+    e.m_size      = size;
+    ring->m_next.store(n + 1, std::memory_order_release);
+}
+
+extern "C" int remi_trace_enable(size_t capacity)
+{
+    std::lock_guard<std::mutex> guard(s_rings_mtx);
+    if(s_capacity == 0) {
+        if(capacity == 0)
+            return REMI_ERR_INVALID_ARG;
+        s_capacity = capacity;
+    }
+    for(auto& ring : s_rings)
+        ring->m_next.store(0, std::memory_order_release);
+    g_trace_enabled = true;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_trace_disable(void)
+{
+    g_trace_enabled = false;
+    return REMI_SUCCESS;
+}
+
+extern "C" int remi_trace_dump(const char* filename)
+{
+    if(filename == NULL)
+        return REMI_ERR_INVALID_ARG;
+    FILE* out = fopen(filename, "w");
+    if(out == NULL)
+        return REMI_ERR_IO;
+
+    std::lock_guard<std::mutex> guard(s_rings_mtx);
+    int pid = getpid();
+    const char* sep = "";
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for(auto& ring : s_rings) {
+        fprintf(out, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%u,"
+                     "\"args\":{\"name\":\"es-%u\"}}", sep, pid, ring->m_index, ring->m_index);
+        sep = ",";
+        uint64_t next  = ring->m_next.load(std::memory_order_acquire);
+        uint64_t count = std::min<uint64_t>(next, ring->m_events.size());
+        for(uint64_t n = next - count; n < next; n++) {
+            auto& e = ring->m_events[n % ring->m_events.size()];
+            char op[37];
+            uuid_unparse(e.m_op, op);
+            fprintf(out, ",\n{\"ph\":\"%c\",\"cat\":\"remi\",\"name\":\"%s\",\"pid\":%d,\"tid\":%u,"
+                         "\"ts\":%.3f,", e.m_phase, e.m_name, pid, ring->m_index, e.m_timestamp/1e3);
+            if(e.m_phase == 'i')
+                fprintf(out, "\"s\":\"t\",");
+            else
+                fprintf(out, "\"id2\":{\"local\":\"%s/%s/%u/%lu\"},",
+                        e.m_name, op, e.m_file, (unsigned long)e.m_offset);
+            fprintf(out, "\"args\":{\"op\":\"%s\",\"file\":%u,\"offset\":%lu,\"size\":%lu}}",
+                    op, e.m_file, (unsigned long)e.m_offset, (unsigned long)e.m_size);
+        }
+    }
+    fprintf(out, "\n]}\n");
+    int ret = ferror(out) ? REMI_ERR_IO : REMI_SUCCESS;
+    fclose(out);
+    return ret;
+}
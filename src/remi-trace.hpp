@@ -0,0 +1,42 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __REMI_TRACE_HPP
+#define __REMI_TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include "uuid-util.hpp"
+
+/**
+ * Event recorded by the tracing layer. Phases follow the Chrome trace
+ * format: 'b' and 'e' begin and end an asynchronous span (spans of the
+ * same chunk are matched by name, operation, file and offset, so that
+ * pipelined chunks do not have to nest), 'i' is an instant event.
+ */
+struct trace_event {
+    const char*   m_name;
+    char          m_phase;
+    uint64_t      m_timestamp; // ns
+    unsigned char m_op[16];
+    uint32_t      m_file;
+    uint64_t      m_offset;
+    uint64_t      m_size;
+};
+
+extern std::atomic<bool> g_trace_enabled;
+
+/* appends an event to the ring buffer of the calling execution stream */
+void trace_record(const char* name, char phase, const uuid& op,
+                  uint32_t file, uint64_t offset, uint64_t size);
+
+inline void trace(const char* name, char phase, const uuid& op,
+                  uint32_t file = 0, uint64_t offset = 0, uint64_t size = 0)
+{
+    if(g_trace_enabled.load(std::memory_order_relaxed))
+        trace_record(name, phase, op, file, offset, size);
+}
+
+#endif
@@ -24,6 +24,22 @@ class uuid : public std::array<unsigned char,16> {
     uuid& operator=(const uuid& other) = default;
     uuid& operator=(uuid&& other) = default;
 
+    std::string to_string() const {
+        char str[37];
+        uuid_unparse(data(), str);
+        return str;
+    }
+
+    static bool from_string(const char* str, uuid& id) {
+        uuid_t parsed;
+        if(uuid_parse(str, parsed) != 0)
+            return false;
+        for(int i=0; i<16; i++) {
+            id[i] = parsed[i];
+        }
+        return true;
+    }
+
     template<typename T>
     friend T& operator<<(T& stream, const uuid& id);
 };
@@ -0,0 +1,132 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include "remi-dedup.hpp"
+#include "sha256.hpp"
+#include "fs-util.hpp"
+
+/**
+ * Round trips through the dedup index: entries are found again,
+ * survive reopening the index, are dropped once their file changes,
+ * and the log only keeps the live entries once reopened.
+ */
+class DedupIndexTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(DedupIndexTest);
+    CPPUNIT_TEST(testAddLookup);
+    CPPUNIT_TEST(testReopen);
+    CPPUNIT_TEST(testModifiedFile);
+    CPPUNIT_TEST(testCompaction);
+    CPPUNIT_TEST_SUITE_END();
+
+    std::string m_dir;
+    std::string m_log;
+    std::string m_file;
+    std::string m_hash;
+
+    static const std::string s_content;
+
+    void write_file(const std::string& path, const std::string& content) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+
+    public:
+
+    void setUp() {
+        char tmpl[] = "/tmp/remi-dedup-test-XXXXXX";
+        CPPUNIT_ASSERT(mkdtemp(tmpl) != nullptr);
+        m_dir  = tmpl;
+        m_log  = m_dir + "/index";
+        m_file = m_dir + "/data";
+        write_file(m_file, s_content);
+        sha256 h;
+        h.update(s_content.data(), s_content.size());
+        m_hash = h.hex_digest();
+    }
+
+    void tearDown() {
+        removeRec(m_dir);
+    }
+
+    void testAddLookup() {
+        dedup_index index;
+        CPPUNIT_ASSERT(index.open(m_log));
+        CPPUNIT_ASSERT(index.is_open());
+        std::string path;
+        CPPUNIT_ASSERT(!index.lookup(m_hash, s_content.size(), &path));
+        index.add(m_hash, m_file);
+        CPPUNIT_ASSERT(index.lookup(m_hash, s_content.size(), &path));
+        CPPUNIT_ASSERT_EQUAL(m_file, path);
+        // same hash announced with another size
+        CPPUNIT_ASSERT(!index.lookup(m_hash, s_content.size() + 1, &path));
+    }
+
+    void testReopen() {
+        {
+            dedup_index index;
+            CPPUNIT_ASSERT(index.open(m_log));
+            index.add(m_hash, m_file);
+        }
+        dedup_index index;
+        CPPUNIT_ASSERT(index.open(m_log));
+        std::string path;
+        CPPUNIT_ASSERT(index.lookup(m_hash, s_content.size(), &path));
+        CPPUNIT_ASSERT_EQUAL(m_file, path);
+    }
+
+    void testModifiedFile() {
+        dedup_index index;
+        CPPUNIT_ASSERT(index.open(m_log));
+        index.add(m_hash, m_file);
+        // the file is no longer what was indexed
+        std::ofstream(m_file, std::ios::binary | std::ios::app) << "appended";
+        std::string path;
+        CPPUNIT_ASSERT(!index.lookup(m_hash, s_content.size(), &path));
+    }
+
+    size_t count_lines(const std::string& path) {
+        std::ifstream in(path);
+        std::string line;
+        size_t count = 0;
+        while(std::getline(in, line)) count++;
+        return count;
+    }
+
+    void testCompaction() {
+        auto other = m_dir + "/other";
+        write_file(other, "other content\n");
+        {
+            dedup_index index;
+            CPPUNIT_ASSERT(index.open(m_log));
+            // the same hash indexed several times, and a file that goes away
+            index.add(m_hash, m_file);
+            index.add(m_hash, m_file);
+            index.add(m_hash, m_file);
+            index.add("stale", other);
+        }
+        CPPUNIT_ASSERT_EQUAL((size_t)4, count_lines(m_log));
+        CPPUNIT_ASSERT_EQUAL(0, unlink(other.c_str()));
+        dedup_index index;
+        CPPUNIT_ASSERT(index.open(m_log));
+        CPPUNIT_ASSERT_EQUAL((size_t)1, count_lines(m_log));
+        std::string path;
+        CPPUNIT_ASSERT(index.lookup(m_hash, s_content.size(), &path));
+        CPPUNIT_ASSERT_EQUAL(m_file, path);
+        // the index keeps appending after compaction
+        write_file(other, "other content\n");
+        index.add("other", other);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, count_lines(m_log));
+    }
+};
+
+const std::string DedupIndexTest::s_content = "content that the provider received\n";
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DedupIndexTest);
@@ -0,0 +1,129 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "fs-util.hpp"
+
+/**
+ * File system helpers used on migrated files: trees are removed
+ * entirely without following symbolic links out of them, and staged
+ * files are renamed into place without replacing existing ones.
+ */
+class FsUtilTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(FsUtilTest);
+    CPPUNIT_TEST(testRemoveTree);
+    CPPUNIT_TEST(testRemoveTreeKeepsLinkTargets);
+    CPPUNIT_TEST(testRemoveTreeRelative);
+    CPPUNIT_TEST(testRenameNoReplace);
+    CPPUNIT_TEST(testRenameNoReplaceExisting);
+    CPPUNIT_TEST_SUITE_END();
+
+    std::string m_dir;
+
+    static void write_file(const std::string& path, const std::string& content) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+
+    static std::string read_file(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    static bool exists(const std::string& path) {
+        struct stat st;
+        return lstat(path.c_str(), &st) == 0;
+    }
+
+    public:
+
+    void setUp() {
+        char tmpl[] = "/tmp/remi-fs-util-test-XXXXXX";
+        CPPUNIT_ASSERT(mkdtemp(tmpl) != nullptr);
+        m_dir = tmpl;
+    }
+
+    void tearDown() {
+        removeRec(m_dir);
+    }
+
+    void testRemoveTree() {
+        auto tree = m_dir + "/tree";
+        mkdirs((tree + "/a/b/c").c_str());
+        mkdirs((tree + "/empty").c_str());
+        write_file(tree + "/file", "file");
+        write_file(tree + "/a/file", "file");
+        write_file(tree + "/a/b/c/file", "file");
+        CPPUNIT_ASSERT_EQUAL(0, removeTreeAt(AT_FDCWD, tree.c_str()));
+        CPPUNIT_ASSERT(!exists(tree));
+        // single files and missing names
+        write_file(m_dir + "/file", "file");
+        CPPUNIT_ASSERT_EQUAL(0, removeTreeAt(AT_FDCWD, (m_dir + "/file").c_str()));
+        CPPUNIT_ASSERT(!exists(m_dir + "/file"));
+        CPPUNIT_ASSERT_EQUAL(0, removeTreeAt(AT_FDCWD, (m_dir + "/missing").c_str()));
+    }
+
+    void testRemoveTreeKeepsLinkTargets() {
+        auto tree    = m_dir + "/tree";
+        auto outside = m_dir + "/outside";
+        mkdirs(tree.c_str());
+        mkdirs(outside.c_str());
+        write_file(outside + "/file", "file");
+        CPPUNIT_ASSERT_EQUAL(0, symlink(outside.c_str(), (tree + "/dir-link").c_str()));
+        CPPUNIT_ASSERT_EQUAL(0, symlink((outside + "/file").c_str(), (tree + "/file-link").c_str()));
+        CPPUNIT_ASSERT_EQUAL(0, removeTreeAt(AT_FDCWD, tree.c_str()));
+        CPPUNIT_ASSERT(!exists(tree));
+        CPPUNIT_ASSERT(exists(outside + "/file"));
+        // a link given as the tree itself is removed, not its target
+        CPPUNIT_ASSERT_EQUAL(0, symlink(outside.c_str(), tree.c_str()));
+        CPPUNIT_ASSERT_EQUAL(0, removeTreeAt(AT_FDCWD, tree.c_str()));
+        CPPUNIT_ASSERT(!exists(tree));
+        CPPUNIT_ASSERT(exists(outside + "/file"));
+    }
+
+    void testRemoveTreeRelative() {
+        mkdirs((m_dir + "/tree/sub").c_str());
+        write_file(m_dir + "/tree/sub/file", "file");
+        write_file(m_dir + "/other", "other");
+        int fd = open(m_dir.c_str(), O_RDONLY | O_DIRECTORY);
+        CPPUNIT_ASSERT(fd != -1);
+        CPPUNIT_ASSERT_EQUAL(0, removeTreeAt(fd, "tree"));
+        close(fd);
+        CPPUNIT_ASSERT(!exists(m_dir + "/tree"));
+        CPPUNIT_ASSERT(exists(m_dir + "/other"));
+    }
+
+    void testRenameNoReplace() {
+        auto from = m_dir + "/staged";
+        auto to   = m_dir + "/final";
+        write_file(from, "staged");
+        CPPUNIT_ASSERT_EQUAL(0, renameNoReplace(from.c_str(), to.c_str()));
+        CPPUNIT_ASSERT(!exists(from));
+        CPPUNIT_ASSERT_EQUAL(std::string("staged"), read_file(to));
+    }
+
+    void testRenameNoReplaceExisting() {
+        auto from = m_dir + "/staged";
+        auto to   = m_dir + "/final";
+        write_file(from, "staged");
+        write_file(to, "existing");
+        CPPUNIT_ASSERT_EQUAL(-1, renameNoReplace(from.c_str(), to.c_str()));
+        CPPUNIT_ASSERT_EQUAL(EEXIST, errno);
+        // neither file was touched
+        CPPUNIT_ASSERT_EQUAL(std::string("staged"), read_file(from));
+        CPPUNIT_ASSERT_EQUAL(std::string("existing"), read_file(to));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FsUtilTest);
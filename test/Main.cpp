@@ -0,0 +1,22 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+int main(int argc, char** argv)
+{
+    // some of the classes under test use Argobots mutexes
+    tl::abt scope;
+    CppUnit::TextUi::TestRunner runner;
+    CppUnit::TestFactoryRegistry& registry =
+        CppUnit::TestFactoryRegistry::getRegistry();
+    runner.addTest(registry.makeTest());
+    bool wasSuccessful = runner.run("", false);
+    return wasSuccessful ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <string>
+#include <utility>
+#include "sha256.hpp"
+
+/**
+ * Known-answer tests for the SHA-256 used to identify file contents,
+ * with the FIPS 180-4 example messages and messages around the lengths
+ * at which the padding spills into an extra block.
+ */
+class Sha256Test : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(Sha256Test);
+    CPPUNIT_TEST(testFipsVectors);
+    CPPUNIT_TEST(testPaddingBoundaries);
+    CPPUNIT_TEST(testIncrementalUpdates);
+    CPPUNIT_TEST_SUITE_END();
+
+    static std::string digest(const std::string& message) {
+        sha256 h;
+        h.update(message.data(), message.size());
+        return h.hex_digest();
+    }
+
+    public:
+
+    void testFipsVectors() {
+        CPPUNIT_ASSERT_EQUAL(
+            std::string("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"),
+            digest(""));
+        CPPUNIT_ASSERT_EQUAL(
+            std::string("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"),
+            digest("abc"));
+        // 448-bit message
+        CPPUNIT_ASSERT_EQUAL(
+            std::string("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"),
+            digest("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+        // 896-bit message
+        CPPUNIT_ASSERT_EQUAL(
+            std::string("cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"),
+            digest("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+                   "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu"));
+        // one million repetitions of 'a'
+        CPPUNIT_ASSERT_EQUAL(
+            std::string("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"),
+            digest(std::string(1000000, 'a')));
+    }
+
+    void testPaddingBoundaries() {
+        // the length fits in the last block up to 55 bytes of data,
+        // from 56 bytes on the padding needs another block
+        static const std::pair<size_t, const char*> expected[] = {
+            {  55, "9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318" },
+            {  56, "b35439a4ac6f0948b6d6f9e3c6af0f5f590ce20f1bde7090ef7970686ec6738a" },
+            {  57, "f13b2d724659eb3bf47f2dd6af1accc87b81f09f59f2b75e5c0bed6589dfe8c6" },
+            {  63, "7d3e74a05d7db15bce4ad9ec0658ea98e3f06eeecf16b4c6fff2da457ddc2f34" },
+            {  64, "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb" },
+            {  65, "635361c48bb9eab14198e76ea8ab7f1a41685d6ad62aa9146d301d4f17eb0ae0" },
+            { 119, "31eba51c313a5c08226adf18d4a359cfdfd8d2e816b13f4af952f7ea6584dcfb" },
+            { 120, "2f3d335432c70b580af0e8e1b3674a7c020d683aa5f73aaaedfdc55af904c21c" },
+        };
+        for(auto& e : expected) {
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(std::to_string(e.first) + " bytes",
+                std::string(e.second), digest(std::string(e.first, 'a')));
+        }
+    }
+
+    void testIncrementalUpdates() {
+        // feeding the data in pieces that straddle block boundaries
+        // must give the same digest as feeding it at once
+        std::string message;
+        for(unsigned i = 0; i < 1000; i++)
+            message += (char)('a' + i % 26);
+        auto expected = digest(message);
+        for(size_t piece : {1, 7, 55, 56, 63, 64, 65, 200}) {
+            sha256 h;
+            for(size_t offset = 0; offset < message.size(); offset += piece)
+                h.update(message.data() + offset, std::min(piece, message.size() - offset));
+            CPPUNIT_ASSERT_EQUAL_MESSAGE("pieces of " + std::to_string(piece) + " bytes",
+                expected, h.hex_digest());
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Sha256Test);
@@ -0,0 +1,101 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <string>
+#include "remi-space.hpp"
+#include "fs-util.hpp"
+
+/**
+ * Reservations in the space ledger are checked against the free space
+ * of the file system holding the path, add up with each other, and are
+ * given back when released. Sizes are taken relative to the space
+ * available in the temporary directory the tests run in.
+ */
+class SpaceLedgerTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(SpaceLedgerTest);
+    CPPUNIT_TEST(testReserveMissingPath);
+    CPPUNIT_TEST(testReservationsAddUp);
+    CPPUNIT_TEST(testReleaseGivesSpaceBack);
+    CPPUNIT_TEST(testTooManyFiles);
+    CPPUNIT_TEST_SUITE_END();
+
+    std::string m_dir;
+    dev_t       m_dev;
+    uint64_t    m_available;
+    uint64_t    m_files;
+
+    public:
+
+    void setUp() {
+        char tmpl[] = "/tmp/remi-space-test-XXXXXX";
+        CPPUNIT_ASSERT(mkdtemp(tmpl) != nullptr);
+        m_dir = tmpl;
+        struct stat st;
+        struct statvfs vfs;
+        CPPUNIT_ASSERT_EQUAL(0, stat(m_dir.c_str(), &st));
+        CPPUNIT_ASSERT_EQUAL(0, statvfs(m_dir.c_str(), &vfs));
+        m_dev       = st.st_dev;
+        m_available = vfs.f_blocks ? (uint64_t)vfs.f_bavail * vfs.f_frsize : 0;
+        m_files     = vfs.f_files ? vfs.f_favail : 0;
+    }
+
+    void tearDown() {
+        removeRec(m_dir);
+    }
+
+    void testReserveMissingPath() {
+        // the root of a fileset does not need to exist yet
+        space_ledger ledger;
+        dev_t dev;
+        CPPUNIT_ASSERT_EQUAL((int32_t)REMI_SUCCESS,
+            ledger.reserve(m_dir + "/not/created/yet", 4096, 1, &dev));
+        CPPUNIT_ASSERT(dev == m_dev);
+        ledger.release(dev, 4096);
+    }
+
+    void testReservationsAddUp() {
+        if(m_available == 0) return; // capacity not reported
+        space_ledger ledger;
+        dev_t dev;
+        uint64_t size = m_available / 4 * 3;
+        CPPUNIT_ASSERT_EQUAL((int32_t)REMI_SUCCESS, ledger.reserve(m_dir, size, 1, &dev));
+        CPPUNIT_ASSERT_EQUAL((int32_t)REMI_ERR_NO_SPACE, ledger.reserve(m_dir, size, 1, &dev));
+        // a rejected reservation is not counted
+        CPPUNIT_ASSERT_EQUAL((int32_t)REMI_SUCCESS,
+            ledger.reserve(m_dir, m_available / 8, 1, &dev));
+    }
+
+    void testReleaseGivesSpaceBack() {
+        if(m_available == 0) return; // capacity not reported
+        space_ledger ledger;
+        dev_t dev;
+        uint64_t size = m_available / 4 * 3;
+        for(unsigned i = 0; i < 10; i++) {
+            CPPUNIT_ASSERT_EQUAL((int32_t)REMI_SUCCESS, ledger.reserve(m_dir, size, 1, &dev));
+            // reservations are released in parts, as files get allocated
+            ledger.release(dev, size / 2);
+            ledger.release(dev, size - size / 2);
+        }
+        // releasing more than reserved, or on another device, is harmless
+        ledger.release(dev, size);
+        ledger.release(dev + 1, size);
+        CPPUNIT_ASSERT_EQUAL((int32_t)REMI_SUCCESS, ledger.reserve(m_dir, size, 1, &dev));
+    }
+
+    void testTooManyFiles() {
+        if(m_available == 0 || m_files == 0) return; // not reported
+        space_ledger ledger;
+        dev_t dev;
+        CPPUNIT_ASSERT_EQUAL((int32_t)REMI_ERR_NO_SPACE,
+            ledger.reserve(m_dir, 0, m_files + 1, &dev));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SpaceLedgerTest);
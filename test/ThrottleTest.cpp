@@ -0,0 +1,111 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdexcept>
+#include <thallium.hpp>
+#include "remi-throttle.hpp"
+
+namespace tl = thallium;
+
+/**
+ * Token buckets pace their callers and admission gates give their slots
+ * back, including the slots of operations reclaimed while waiting.
+ * Gates are entered with a callback that fails the test instead of
+ * blocking it forever when a slot is not available.
+ */
+class ThrottleTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(ThrottleTest);
+    CPPUNIT_TEST(testTokenBucketDisabled);
+    CPPUNIT_TEST(testTokenBucketDebt);
+    CPPUNIT_TEST(testAdmissionUnlimited);
+    CPPUNIT_TEST(testAdmissionSlotsReleased);
+    CPPUNIT_TEST(testAdmissionRaisedMax);
+    CPPUNIT_TEST(testAdmissionReclaim);
+    CPPUNIT_TEST_SUITE_END();
+
+    /* enters the gate, failing if no slot is available within 100ms */
+    static void enter_or_fail(admission_gate& gate) {
+        gate.enter(0.1, []() {
+            throw std::runtime_error("no slot available in the admission gate");
+        });
+    }
+
+    public:
+
+    void testTokenBucketDisabled() {
+        tl::engine engine("na+sm", THALLIUM_CLIENT_MODE);
+        token_bucket bucket;
+        CPPUNIT_ASSERT_EQUAL(0.0, bucket.rate());
+        double start = tl::timer::wtime();
+        bucket.acquire(engine, 1e12);
+        CPPUNIT_ASSERT(tl::timer::wtime() - start < 0.1);
+    }
+
+    void testTokenBucketDebt() {
+        tl::engine engine("na+sm", THALLIUM_CLIENT_MODE);
+        token_bucket bucket;
+        bucket.set_rate(1000.0);
+        CPPUNIT_ASSERT_EQUAL(1000.0, bucket.rate());
+        // the bucket starts full
+        double start = tl::timer::wtime();
+        bucket.acquire(engine, 1000.0);
+        CPPUNIT_ASSERT(tl::timer::wtime() - start < 0.1);
+        // going 300 tokens into debt takes about 300ms to repay
+        start = tl::timer::wtime();
+        bucket.acquire(engine, 300.0);
+        double elapsed = tl::timer::wtime() - start;
+        CPPUNIT_ASSERT(elapsed > 0.2);
+        CPPUNIT_ASSERT(elapsed < 2.0);
+    }
+
+    void testAdmissionUnlimited() {
+        admission_gate gate;
+        for(unsigned i = 0; i < 100; i++)
+            enter_or_fail(gate);
+    }
+
+    void testAdmissionSlotsReleased() {
+        admission_gate gate;
+        gate.set_max(2);
+        // every slot taken is given back, whatever the number of rounds
+        for(unsigned i = 0; i < 10; i++) {
+            enter_or_fail(gate);
+            enter_or_fail(gate);
+            gate.leave();
+            gate.leave();
+        }
+        CPPUNIT_ASSERT_THROW(
+            { enter_or_fail(gate); enter_or_fail(gate); enter_or_fail(gate); },
+            std::runtime_error);
+    }
+
+    void testAdmissionRaisedMax() {
+        admission_gate gate;
+        gate.set_max(1);
+        enter_or_fail(gate);
+        gate.set_max(2);
+        enter_or_fail(gate);
+    }
+
+    void testAdmissionReclaim() {
+        admission_gate gate;
+        gate.set_max(1);
+        enter_or_fail(gate);
+        // the waiting caller gets the slot of the operation it reclaims
+        unsigned reclaimed = 0;
+        gate.enter(0.01, [&]() {
+            if(++reclaimed > 1)
+                throw std::runtime_error("reclaimed slot not given to the waiting caller");
+            gate.leave();
+        });
+        CPPUNIT_ASSERT_EQUAL(1u, reclaimed);
+        gate.leave();
+        enter_or_fail(gate);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ThrottleTest);
@@ -0,0 +1,118 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <functional>
+#include "remi-autotune.hpp"
+
+/**
+ * Drives the transfer tuner with simulated targets whose throughput
+ * depends on the chunk size, checking that it climbs to the best chunk
+ * size, stays within its bounds, and sizes the pipeline after the time
+ * the sender spends waiting on RPCs.
+ */
+class XferTunerTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(XferTunerTest);
+    CPPUNIT_TEST(testWindow);
+    CPPUNIT_TEST(testFindsBestChunkSize);
+    CPPUNIT_TEST(testChunkSizeBounds);
+    CPPUNIT_TEST(testPipelineDepth);
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr size_t s_window = 8;
+    static constexpr size_t MiB      = 1048576;
+
+    using throughput_fn = std::function<double(size_t)>;
+
+    /* sends one window of chunks at the throughput the target gives for
+       the current chunk size, waiting on RPCs for the given fraction of
+       the time */
+    static void run_window(xfer_tuner& tuner, double& now,
+                           const throughput_fn& throughput, double waiting = 0.25) {
+        for(size_t i = 0; i < s_window; i++) {
+            size_t bytes = tuner.xfer_size();
+            double time  = bytes / throughput(bytes);
+            now += time;
+            tuner.record(bytes, waiting * time, now);
+        }
+    }
+
+    /* throughput growing with the chunk size up to peak, then dropping */
+    static throughput_fn peaking_at(size_t peak) {
+        return [peak](size_t size) {
+            return size <= peak ? 1e9 * size / peak : 1e9 * peak / size;
+        };
+    }
+
+    public:
+
+    void testWindow() {
+        double now = 0.0;
+        xfer_tuner tuner(xfer_tuning(), now);
+        // nothing changes until a full window was sent
+        for(size_t i = 0; i < s_window - 1; i++) {
+            now += 0.001;
+            tuner.record(MiB, 0.0, now);
+            CPPUNIT_ASSERT_EQUAL(MiB, tuner.xfer_size());
+        }
+        now += 0.001;
+        tuner.record(MiB, 0.0, now);
+        CPPUNIT_ASSERT_EQUAL(2*MiB, tuner.xfer_size());
+    }
+
+    void testFindsBestChunkSize() {
+        double now = 0.0;
+        xfer_tuner tuner(xfer_tuning(), now);
+        auto throughput = peaking_at(4*MiB);
+        for(unsigned i = 0; i < 20; i++)
+            run_window(tuner, now, throughput);
+        CPPUNIT_ASSERT_EQUAL(4*MiB, tuner.xfer_size());
+        CPPUNIT_ASSERT_EQUAL(4*MiB, tuner.best().m_xfer_size);
+        // starting from a larger size, it climbs down to the same one
+        xfer_tuning initial;
+        initial.m_xfer_size = 32*MiB;
+        xfer_tuner other(initial, now);
+        for(unsigned i = 0; i < 20; i++)
+            run_window(other, now, throughput);
+        CPPUNIT_ASSERT_EQUAL(4*MiB, other.best().m_xfer_size);
+    }
+
+    void testChunkSizeBounds() {
+        double now = 0.0;
+        xfer_tuning initial;
+        initial.m_xfer_size = 65536;
+        xfer_tuner smallest(initial, now);
+        for(unsigned i = 0; i < 20; i++) {
+            run_window(smallest, now, peaking_at(1));
+            CPPUNIT_ASSERT(smallest.xfer_size() >= 65536);
+        }
+        CPPUNIT_ASSERT_EQUAL((size_t)65536, smallest.best().m_xfer_size);
+        xfer_tuner largest(xfer_tuning(), now);
+        for(unsigned i = 0; i < 20; i++) {
+            run_window(largest, now, peaking_at(1024*MiB));
+            CPPUNIT_ASSERT(largest.xfer_size() <= 64*MiB);
+        }
+        CPPUNIT_ASSERT_EQUAL(64*MiB, largest.best().m_xfer_size);
+    }
+
+    void testPipelineDepth() {
+        double now = 0.0;
+        xfer_tuner tuner(xfer_tuning(), now);
+        auto throughput = peaking_at(4*MiB);
+        // mostly waiting on RPCs: the pipeline deepens up to its maximum
+        for(unsigned i = 0; i < 20; i++)
+            run_window(tuner, now, throughput, 0.9);
+        CPPUNIT_ASSERT_EQUAL((size_t)8, tuner.pipeline_depth());
+        CPPUNIT_ASSERT_EQUAL((size_t)8, tuner.best().m_pipeline_depth);
+        // never waiting: it shrinks back to two RPCs in flight
+        for(unsigned i = 0; i < 20; i++)
+            run_window(tuner, now, throughput, 0.0);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, tuner.pipeline_depth());
+        CPPUNIT_ASSERT_EQUAL((size_t)2, tuner.best().m_pipeline_depth);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(XferTunerTest);